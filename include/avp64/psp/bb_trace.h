@@ -0,0 +1,120 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef AVP64_PSP_BB_TRACE_H
+#define AVP64_PSP_BB_TRACE_H
+
+#include "avp64/common.h"
+
+#include <atomic>
+#include <thread>
+
+namespace avp64 {
+namespace psp {
+
+// binary basic block trace file: a header followed by one record per block,
+// each record holds the zigzag varint encoded address delta to the previous
+// block and the varint encoded time delta in picoseconds
+struct bb_trace_header {
+    char magic[8];
+    vcml::u32 version;
+    vcml::u32 reserved;
+    vcml::u64 core_id;
+};
+
+constexpr const char BB_TRACE_MAGIC[8] = { 'A', 'V', 'P', '6',
+                                           '4', 'B', 'B', 'T' };
+constexpr vcml::u32 BB_TRACE_VERSION = 1;
+
+// records are pushed by the core into a single producer single consumer
+// ring buffer; a background thread copies them into a memory mapped file
+class bb_trace_writer
+{
+public:
+    static constexpr size_t MAX_RECORD_SIZE = 20;
+
+    bb_trace_writer(const string& path, vcml::u64 core_id,
+                    size_t ring_size = 1 << 20);
+    ~bb_trace_writer();
+
+    bb_trace_writer(const bb_trace_writer&) = delete;
+    bb_trace_writer& operator=(const bb_trace_writer&) = delete;
+
+    void record(vcml::u64 vaddr, vcml::u64 time_ps);
+
+    // waits until all records have been written and truncates the file,
+    // errors are raised here but only logged when closing on destruction
+    void close();
+
+    // stops the background thread after it wrote all records, e.g. before
+    // fork(), and starts it again; no records may be added in between
+    void suspend();
+    void resume();
+
+    // releases the file without writing to it, used by forked children
+    // whose inherited file still belongs to the parent
+    void discard();
+
+    vcml::u64 num_records() const { return m_num_records; }
+    vcml::u64 file_size() const { return m_file_pos; }
+
+private:
+    vector<vcml::u8> m_ring;
+    size_t m_mask;
+
+    alignas(64) std::atomic<size_t> m_head;
+    alignas(64) std::atomic<size_t> m_tail;
+
+    vcml::u64 m_prev_vaddr;
+    vcml::u64 m_prev_time;
+    vcml::u64 m_num_records;
+
+    int m_fd;
+    vcml::u8* m_map;
+    size_t m_map_size;
+    size_t m_file_pos;
+
+    std::atomic<bool> m_stop;
+    std::thread m_thread;
+
+    bool close_file(string& error);
+    void writer();
+    void drain();
+    void write_out(const vcml::u8* data, size_t n);
+};
+
+class bb_trace_reader
+{
+public:
+    explicit bb_trace_reader(const string& path);
+    ~bb_trace_reader();
+
+    bb_trace_reader(const bb_trace_reader&) = delete;
+    bb_trace_reader& operator=(const bb_trace_reader&) = delete;
+
+    vcml::u64 core_id() const { return m_core_id; }
+
+    // returns false at the end of the trace
+    bool next(vcml::u64& vaddr, vcml::u64& time_ps);
+
+private:
+    vcml::u8* m_map;
+    size_t m_size;
+    size_t m_pos;
+    vcml::u64 m_core_id;
+    vcml::u64 m_vaddr;
+    vcml::u64 m_time;
+
+    bool read_varint(vcml::u64& val);
+};
+
+} // namespace psp
+} // namespace avp64
+
+#endif
@@ -11,44 +11,262 @@
 #define AVP64_PSP_CORE_H
 
 #include "avp64/common.h"
+#include "avp64/psp/bb_trace.h"
+#include "avp64/psp/core_stats.h"
+#include "avp64/psp/coverage.h"
+#include "avp64/psp/idle_tracker.h"
 #include "avp64/psp/mem_protector.h"
+#include "avp64/psp/ocx_library.h"
+#include "avp64/psp/profiler.h"
+#include "avp64/psp/quantum.h"
+#include "avp64/psp/snapshot.h"
+#include "avp64/psp/timer_wheel.h"
+#include "avp64/psp/worker.h"
 #include "ocx/ocx.h"
 
+#include <unordered_set>
+
 namespace avp64 {
 namespace psp {
 
-typedef ocx::core* (*create_instance_t)(ocx::u64, ocx::env&, const char*);
-typedef void (*delete_instance_t)(ocx::core*);
-
 class core : public vcml::processor, private ocx::env, private mem_protector_if
 {
 private:
     ocx::core* m_core;
+    ocx::core_inv_range_extension* m_inv_range;
     sc_core::sc_event m_irqev;
     vcml::u64 m_core_id;
     vcml::u64 m_proc_id;
     vcml::u64 m_run_cycles;
     vcml::u64 m_sleep_cycles;
+    idle_tracker* m_idle;
+
+    // generic timer deadlines are dispatched by the cluster, cores used
+    // without a cluster dispatch them on their own
+    timer_dispatcher* m_timers;
+    unique_ptr<timer_dispatcher> m_own_timers;
+    size_t m_timer_base;
+
+    // guest time at which a restored snapshot was taken
+    vcml::u64 m_time_offset_ps;
+    vector<std::function<void()>> m_before_quantum;
+
+    // index of the forked child this core runs in, 0 in the original process
+    size_t m_fork_id;
+
     bool m_transport;
-    void* m_ocx_handle;
-    create_instance_t m_create_instance;
-    delete_instance_t m_delete_instance;
+    shared_ptr<ocx_library> m_ocx;
+    vcml::u64 m_num_resets;
+    double m_reset_time;
     vector<weak_ptr<core>> m_syscall_subscriber;
-    list<pair<int, shared_ptr<void>>> m_syscalls;
+    vector<core*> m_syscall_peers;
+
+    struct pending_syscall {
+        int callno;
+        shared_ptr<void> arg;
+        vcml::u64 time_ps;
+    };
+
+    // syscalls other cores broadcast asynchronously, drained by the thread
+    // executing this core at the start of its next quantum
+    std::mutex m_syscall_mtx;
+    vector<pending_syscall> m_syscalls;
+    std::atomic<bool> m_has_syscalls;
+    size_t m_syscall_max_depth;
+    vcml::u64 m_syscalls_drained;
+    vcml::u64 m_syscall_latency_ps;
+    vcml::u64 m_syscall_max_latency_ps;
+
+    struct page_update {
+        vcml::u64 page_addr;
+        vcml::u64 start;
+        vcml::u64 end;
+    };
+
+    static constexpr size_t PAGE_UPDATE_SLOTS = 64;
+
+    // host thread currently executing this core and the code pages that
+    // other threads asked it to invalidate; these arrive from the segfault
+    // handler, so they are queued without allocating, if the queue runs
+    // full all translations are dropped instead
+    std::atomic<std::thread::id> m_thread;
+    spin_lock m_page_update_lock;
+    array<page_update, PAGE_UPDATE_SLOTS> m_page_updates;
+    size_t m_num_page_updates;
+    bool m_page_update_overflow;
+    std::atomic<bool> m_has_page_updates;
+
+    // counted by whichever thread wrote the page, folded into the stats by
+    // the thread executing this core
+    std::atomic<vcml::u64> m_page_updates_avoided;
+
+    // DMI invalidations that arrived while a worker executed this core
+    std::mutex m_dmi_flush_mtx;
+    vector<vcml::range> m_dmi_flushes;
+    std::atomic<bool> m_has_dmi_flushes;
+
+    struct dmi_region {
+        bool valid;
+        vcml::u64 start;
+        vcml::u64 end;
+        ocx::u8* ptr;
+        vcml::u64 page_size;
+        size_t stats;
+    };
+
+    struct region_stats {
+        vcml::range addr;
+        bool posted;
+        vcml::u64 transports;
+        vcml::u64 posted_writes;
+        vcml::u64 dmi_hits;
+    };
+
+    enum dmi_direction : size_t {
+        DMI_READ = 0,
+        DMI_WRITE = 1,
+        DMI_NUM_DIRECTIONS = 2,
+    };
+
+    static constexpr size_t DMI_MRU_SIZE = 4;
+    static constexpr size_t NO_DMI_SIZE = 8;
+
+    // most recently used DMI regions per direction, most recent first;
+    // each entry remembers the page size it was looked up with
+    array<array<dmi_region, DMI_MRU_SIZE>, DMI_NUM_DIRECTIONS> m_dmi_mru;
+
+    // MMIO pages that recently refused DMI, so that page pointer lookups
+    // for device memory do not query the bus over and over again
+    array<array<vcml::u64, NO_DMI_SIZE>, DMI_NUM_DIRECTIONS> m_no_dmi;
+    array<size_t, DMI_NUM_DIRECTIONS> m_no_dmi_idx;
+
+    // sideband info for all combinations of debug, exclusive and secure
+    vector<vcml::tlm_sbi> m_sbi;
+
+    // designated device ranges and memory regions seen through DMI; the
+    // regions do not overlap and m_region_index keeps them sorted by start
+    // address for lookups during transport
+    vector<region_stats> m_regions;
+    vector<size_t> m_region_index;
+    core_stats m_stats;
+
+    // code pages QEMU holds translations of, i.e. the pages it protected
+    // since they were last written or the translation cache was flushed
+    std::unordered_set<vcml::u64> m_code_pages;
+
+    // code pages written by the executing thread itself; this happens in the
+    // segfault handler, which must not free memory, so they are only
+    // removed from m_code_pages at the next translation or quantum
+    array<vcml::u64, PAGE_UPDATE_SLOTS> m_written_pages;
+    size_t m_num_written_pages;
+    bool m_written_pages_overflow;
+
+    // posted writes, each forwarded with its original width; a failed one
+    // is reported to the core with the next transport that is not posted
+    static constexpr size_t POSTED_WRITE_MAX = 16;
+    static constexpr size_t POSTED_WRITE_DEPTH = 16;
+
+    struct posted_write {
+        vcml::u64 addr;
+        size_t size;
+        size_t sbi;
+        array<vcml::u8, POSTED_WRITE_MAX> data;
+    };
+
+    array<posted_write, POSTED_WRITE_DEPTH> m_posted;
+    size_t m_num_posted;
+    tlm::tlm_response_status m_posted_error;
+
+    // guest pc sampling, instructions are accumulated between samples
+    unique_ptr<profiler> m_profiler;
+    vcml::u64 m_profile_insns;
+
+    // basic block tracing via vcml subscribers and/or a binary trace file
+    bool m_bb_subscribed;
+    unique_ptr<bb_trace_writer> m_bb_trace;
+
+    // executed blocks by physical address; blocks already seen during the
+    // current quantum are filtered by virtual address to skip virt_to_phys
+    static constexpr size_t COVERAGE_SEEN_SIZE = 4096;
+    bool m_coverage_on;
+    coverage_map m_coverage;
+    vector<vcml::u64> m_coverage_seen;
+
+    quantum_controller m_quantum;
+
+    struct deferred_op {
+        enum kind { NOTIFY, CANCEL, SIGNAL, INTERRUPT, TIMER } op;
+        vcml::u64 id;
+        vcml::u64 arg;
+    };
+
+    // parallel mode: quanta run on a pinned worker thread, everything that
+    // touches SystemC is handed back to this core's SystemC thread; timer
+    // updates are deferred until it gets control again
+    unique_ptr<worker> m_worker;
+    vector<deferred_op> m_deferred;
+
+    // the OCX core is not thread-safe, so interrupts and timer events that
+    // SystemC raises while the worker executes it are queued and applied
+    // by the worker before it continues
+    std::mutex m_inbound_mtx;
+    vector<deferred_op> m_inbound;
+    bool m_core_busy;
 
     void timer_irq_trigger(int timer_id);
+    bool irq_pending();
     void load_symbols();
 
-    template <typename T>
-    T get_ocx_function_ptr(const char* fn);
-
     void open_core();
     void close_core();
 
+    void invalidate_code_page(vcml::u64 page_addr, vcml::u64 start,
+                              vcml::u64 end);
+    void drain_page_updates();
+    void drain_written_pages();
+    void drain_dmi_flushes();
+    void queue_syscall(int callno, const shared_ptr<void>& arg,
+                       vcml::u64 time_ps);
+    void drain_syscalls();
+    void advise_hugepages(const tlm::tlm_dmi& dmi);
+
+    ocx::u8* lookup_dmi_mru(dmi_direction dir, vcml::u64 page_paddr);
+    void insert_dmi_mru(dmi_direction dir, const tlm::tlm_dmi& dmi,
+                        vcml::u64 page_size);
+    void flush_dmi_mru(vcml::u64 start, vcml::u64 end);
+    bool lookup_no_dmi(dmi_direction dir, vcml::u64 page_paddr) const;
+    void insert_no_dmi(dmi_direction dir, vcml::u64 page_paddr);
+    void flush_no_dmi(vcml::u64 start, vcml::u64 end);
+
+    region_stats* find_region(vcml::u64 addr);
+    size_t find_dmi_region(const tlm::tlm_dmi& dmi);
+    size_t insert_region(const region_stats& region);
+    void post_write(const ocx::transaction& tx, size_t sbi);
+    void flush_posted_writes();
+
+    bool read_guest_u64(vcml::u64 vaddr, vcml::u64& val);
+    void sample_profile(vcml::u64 insns);
+    void write_profile();
+    string symbolize(vcml::u64 addr);
+
+    void update_bb_trace();
+    string output_file(const string& base) const;
+    int worker_cpu() const;
+
+    bool on_worker() const { return m_worker && m_worker->on_worker(); }
+    void run_quantum(size_t cycles);
+    void sc_call(const worker::function& func);
+    void apply_deferred();
+    void apply_inbound(const deferred_op& op);
+    void run_or_queue(const deferred_op& op);
+    void set_core_busy(bool busy);
+    void record_coverage(vcml::u64 vaddr);
+
 protected:
     virtual void interrupt(size_t irq, bool set) override;
     virtual void simulate(size_t cycles) override;
     virtual void end_of_elaboration() override;
+    virtual void end_of_simulation() override;
 
     virtual bool read_reg_dbg(size_t regno, void* buf, size_t len) override;
     virtual bool write_reg_dbg(size_t regno, const void* buf,
@@ -87,16 +305,54 @@ public:
         ARM_TIMER_COUNT = 4,
     };
 
+    vcml::property<bool> hugepages;
+    vcml::property<vector<vcml::range>> posted_writes;
+
+    vcml::property<bool> profile;
+    vcml::property<vcml::u64> profile_interval;
+    vcml::property<size_t> profile_depth;
+    vcml::property<size_t> profile_buffer;
+    vcml::property<string> profile_output;
+
+    vcml::property<string> bbtrace_file;
+    vcml::property<string> coverage_file;
+
+    vcml::property<sc_core::sc_time> quantum_min;
+    vcml::property<sc_core::sc_time> quantum_max;
+
+    vcml::property<bool> parallel;
+    // runs the quanta of all cores one after the other on their worker
+    // threads, i.e. sequentially; there is no barrier at the quantum end
+    vcml::property<bool> parallel_deterministic;
+    vcml::property<bool> parallel_pin;
+
+    vcml::property<bool> reset_in_place;
+
+    vcml::property<string> tbsize;
+    vcml::property<bool> gicv3;
+
     vcml::gpio_initiator_array<ARM_TIMER_COUNT> timer_irq_out;
-    array<sc_core::sc_event, ARM_TIMER_COUNT> timer_events;
 
     void log_timing_info() const;
 
+    void start_binary_trace(const string& path);
+    void stop_binary_trace();
+    void start_coverage();
+    void stop_coverage();
+    const coverage_map& coverage() const { return m_coverage; }
+    const quantum_controller& quantum() const { return m_quantum; }
+    const core_stats& stats() const { return m_stats; }
+    size_t code_pages() const { return m_code_pages.size(); }
+
     virtual ocx::u8* get_page_ptr_r(ocx::u64 page_paddr) override;
     virtual ocx::u8* get_page_ptr_w(ocx::u64 page_paddr) override;
 
     virtual void protect_page(ocx::u8* page_ptr, ocx::u64 page_addr) override;
     virtual void update_page(vcml::u64 page_addr) override;
+    virtual void update_page_range(vcml::u64 page_addr, vcml::u64 start,
+                                   vcml::u64 end) override;
+    virtual void page_written(mem_protector_if* const* owners,
+                              size_t n) override;
 
     virtual ocx::response transport(const ocx::transaction& tx) override;
     virtual void signal(ocx::u64 sigid, bool set) override;
@@ -118,6 +374,21 @@ public:
                                    ocx::u64 data, bool iswr) override;
 
     void inject_cpu(core* cpu);
+    void set_idle_tracker(idle_tracker* idle) { m_idle = idle; }
+    void use_timers(timer_dispatcher& timers);
+
+    // register, generic timer and guest time state
+    void save_state(snapshot_section& sec);
+    void restore_state(snapshot_section& sec);
+
+    // func is called from the SystemC thread of this core right before its
+    // next quantum, i.e. after resets have been processed
+    void before_quantum(const std::function<void()>& func);
+
+    // stops the host threads of this core before fork() and restarts them
+    // in parent and child afterwards; children write their own outputs
+    void before_fork();
+    void after_fork(size_t child_id);
 
     virtual vcml::u64 cycle_count() const override;
     virtual bool disassemble(vcml::u8* ibuf, vcml::u64& addr,
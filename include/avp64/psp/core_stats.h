@@ -0,0 +1,61 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef AVP64_PSP_CORE_STATS_H
+#define AVP64_PSP_CORE_STATS_H
+
+#include "avp64/common.h"
+
+namespace avp64 {
+namespace psp {
+
+// hot path counters of a core; plain integers that are only written by the
+// thread executing the core and read at quantum boundaries; they accumulate
+// over the whole simulation, resets of the core do not clear them
+struct core_stats {
+    vcml::u64 quanta;
+    vcml::u64 transport_read;
+    vcml::u64 transport_write;
+    vcml::u64 transport_debug;
+    vcml::u64 transport_excl;
+    vcml::u64 dmi_requests;
+    vcml::u64 dmi_misses;
+    vcml::u64 page_updates;
+    vcml::u64 page_updates_avoided;
+    vcml::u64 wfi;
+    vcml::u64 timer_notify;
+    vcml::u64 timer_cancel;
+    vcml::u64 syscalls;
+    vcml::u64 tb_flushes;
+    vcml::u64 code_pages;
+    vcml::u64 code_pages_retranslated;
+
+    struct field {
+        const char* name;
+        vcml::u64 core_stats::*value;
+    };
+
+    static const array<field, 16> FIELDS;
+
+    core_stats();
+
+    void reset();
+
+    core_stats& operator+=(const core_stats& other);
+    core_stats operator-(const core_stats& other) const;
+
+    static string csv_header();
+    string to_csv() const;
+    string to_json() const;
+};
+
+} // namespace psp
+} // namespace avp64
+
+#endif
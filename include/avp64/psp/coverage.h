@@ -0,0 +1,82 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef AVP64_PSP_COVERAGE_H
+#define AVP64_PSP_COVERAGE_H
+
+#include "avp64/common.h"
+
+#include <functional>
+#include <unordered_map>
+
+namespace avp64 {
+namespace psp {
+
+// coverage file: a header followed by one record per covered page, each
+// record holds the page address and its bitmap, sorted by page address
+struct coverage_header {
+    char magic[8];
+    vcml::u32 version;
+    vcml::u32 reserved;
+    vcml::u64 num_pages;
+};
+
+constexpr const char COVERAGE_MAGIC[8] = { 'A', 'V', 'P', '6',
+                                           '4', 'C', 'O', 'V' };
+constexpr vcml::u32 COVERAGE_VERSION = 1;
+
+// sparse bitmap of executed basic blocks, one bit per 4 byte instruction
+// slot, allocated in chunks of one 4 KiB page
+class coverage_map
+{
+public:
+    static constexpr vcml::u64 PAGE_BITS = 12;
+    static constexpr vcml::u64 PAGE_SIZE = 1ull << PAGE_BITS;
+    static constexpr vcml::u64 SLOT_BITS = 2;
+    static constexpr size_t WORDS = (PAGE_SIZE >> SLOT_BITS) / 64;
+
+    typedef array<vcml::u64, WORDS> bitmap;
+
+    coverage_map();
+    coverage_map(const coverage_map& other);
+    coverage_map& operator=(const coverage_map& other);
+
+    void set(vcml::u64 addr);
+    bool test(vcml::u64 addr) const;
+
+    bool empty() const { return m_pages.empty(); }
+    size_t num_pages() const { return m_pages.size(); }
+    size_t count() const;
+
+    void clear();
+    void merge(const coverage_map& other);
+
+    // calls func for every covered address in ascending order
+    void for_each(const std::function<void(vcml::u64)>& func) const;
+
+    void save(const string& path) const;
+
+    // merges the contents of a coverage file into this map
+    void load(const string& path);
+
+private:
+    std::unordered_map<vcml::u64, bitmap> m_pages;
+
+    // most recently set page, blocks tend to be executed in clusters
+    vcml::u64 m_last_page;
+    bitmap* m_last_bits;
+
+    bitmap& lookup(vcml::u64 page);
+    vector<vcml::u64> sorted_pages() const;
+};
+
+} // namespace psp
+} // namespace avp64
+
+#endif
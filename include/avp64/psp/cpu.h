@@ -12,6 +12,9 @@
 
 #include "avp64/common.h"
 #include "avp64/psp/core.h"
+#include "avp64/psp/host_memory.h"
+
+#include <fstream>
 
 namespace avp64 {
 namespace psp {
@@ -24,6 +27,46 @@ public:
     vcml::property<vector<string>> symbols;
     vcml::property<bool> async;
     vcml::property<unsigned int> async_rate;
+    vcml::property<string> write_tracking;
+    vcml::property<bool> hugepages;
+    vcml::property<vector<vcml::range>> posted_writes;
+
+    vcml::property<bool> profile;
+    vcml::property<vcml::u64> profile_interval;
+    vcml::property<size_t> profile_depth;
+    vcml::property<size_t> profile_buffer;
+    vcml::property<string> profile_output;
+
+    vcml::property<string> bbtrace_file;
+    vcml::property<string> coverage_file;
+
+    vcml::property<sc_core::sc_time> quantum_min;
+    vcml::property<sc_core::sc_time> quantum_max;
+
+    vcml::property<bool> parallel;
+    // runs the quanta of all cores one after the other on their worker
+    // threads, i.e. sequentially; there is no barrier at the quantum end
+    vcml::property<bool> parallel_deterministic;
+    vcml::property<bool> parallel_pin;
+
+    vcml::property<bool> reset_in_place;
+
+    vcml::property<string> tbsize;
+    vcml::property<bool> gicv3;
+
+    vcml::property<string> stats_file;
+    vcml::property<string> stats_format;
+    vcml::property<sc_core::sc_time> stats_interval;
+
+    vcml::property<string> snapshot_file;
+    vcml::property<sc_core::sc_time> snapshot_time;
+    vcml::property<string> restore_file;
+    vcml::property<bool> restore_partial;
+
+    vcml::property<vector<string>> ram_images;
+
+    vcml::property<size_t> fork_children;
+    vcml::property<sc_core::sc_time> fork_time;
 
     vcml::property<vcml::range> gic_cpuif;
     vcml::property<vcml::range> gic_distif;
@@ -50,8 +93,32 @@ public:
     AVP64_KIND(psp::cpu);
 
     vcml::u64 cycle_count() const;
+    core_stats stats() const;
+    coverage_map coverage() const;
+
+    // guest memory included in snapshots and reports, accessed via the bus
+    // of core 0
+    void add_guest_memory(const vcml::range& mem);
+
+    // devices whose registers are included in snapshots
+    void add_snapshot_device(vcml::peripheral& dev);
+
+    // devices that keep state outside of registers, such as FIFOs, queues
+    // or card state; snapshots taken with any of them are only restored if
+    // restore_partial is set, the devices then continue from their reset
+    // state plus the saved registers
+    void add_uncaptured_device(sc_core::sc_object& dev);
+
+    void save_snapshot(const string& path);
+    void load_snapshot(const string& path);
+
+    // forks n children that continue the simulation from this point, the
+    // parent waits for them; returns the index of the child, 0 in the parent
+    size_t fork_simulation(size_t n);
+    size_t failed_children() const { return m_failed_children; }
 
     virtual const char* version() const override;
+    virtual void reset() override;
 
 protected:
     virtual void end_of_elaboration() override;
@@ -70,6 +137,21 @@ private:
         GIC_VCPUIF_HI = GIC_VCPUIF_LO + 0x2000 - 1,
     };
 
+    // configuration registers of the GIC distributor and cpu interface
+    enum : mwr::u64 {
+        GICD_CTLR = 0x000,
+        GICD_IGROUPR = 0x080,
+        GICD_ISENABLER = 0x100,
+        GICD_ICENABLER = 0x180,
+        GICD_IPRIORITYR = 0x400,
+        GICD_ITARGETSR = 0x800,
+        GICD_ICFGR = 0xc00,
+        GICC_CTLR = 0x00,
+        GICC_PMR = 0x04,
+        GICC_BPR = 0x08,
+        GICC_ABPR = 0x1c,
+    };
+
     enum : mwr::u64 {
         PPI_GT_NS = 14,
         PPI_GT_S = 13,
@@ -78,11 +160,54 @@ private:
     };
 
     vector<shared_ptr<core>> m_cores;
+    idle_tracker m_idle;
+    timer_dispatcher m_timers;
 
     vcml::arm::gic400 m_gic;
     vcml::generic::bus m_corebus;
 
     unique_ptr<vcml::debugging::gdbserver> m_gdb;
+
+    std::ofstream m_stats_file;
+    vector<core_stats> m_stats_last;
+
+    vector<vcml::range> m_guest_memory;
+    vector<vcml::peripheral*> m_snapshot_devices;
+    vector<string> m_uncaptured_devices;
+    snapshot m_restore;
+    bool m_restored;
+
+    size_t m_failed_children;
+    size_t m_fork_id;
+    bool m_images_mapped;
+    bool m_started;
+
+    void log_quantum_histogram() const;
+    void open_stats_file();
+    void open_stats_stream();
+    string output_file(const string& base) const;
+    void dump_stats();
+    void stats_thread();
+
+    vector<vcml::u64> gic_registers(bool banked) const;
+    void save_gic(snapshot_section& sec, core& c, bool banked);
+    void restore_gic(snapshot_section& sec, core& c);
+    void save_memory(snapshot_section& sec, const vcml::range& mem);
+    void restore_memory(snapshot_section& sec, const vcml::range& mem);
+    void save_device(snapshot_section& sec, vcml::peripheral& dev);
+    void restore_device(snapshot_section& sec, vcml::peripheral& dev);
+    void restore_shared_state();
+    void snapshot_thread();
+
+    vcml::u8* host_memory(vcml::u64 addr, vcml::u64& end);
+    void map_images();
+    void log_memory_usage();
+    void log_startup();
+    void fork_thread();
+
+    bool cmd_mprotect_stats(const vector<string>& args, std::ostream& os);
+    bool cmd_stats(const vector<string>& args, std::ostream& os);
+    bool cmd_snapshot(const vector<string>& args, std::ostream& os);
 };
 
 } // namespace psp
@@ -0,0 +1,31 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef AVP64_PSP_HOST_MEMORY_H
+#define AVP64_PSP_HOST_MEMORY_H
+
+#include "avp64/common.h"
+
+namespace avp64 {
+namespace psp {
+
+// maps a file copy-on-write to host, replacing the memory there; pages are
+// only read from the file when they are first accessed; returns the number
+// of bytes mapped, 0 if host is not page aligned, the file is larger than
+// limit or cannot be mapped
+size_t map_file(vcml::u8* host, size_t limit, const string& path);
+
+// number of bytes of the pages overlapping [host, host + size) that are
+// currently backed by physical memory
+size_t resident_size(const vcml::u8* host, size_t size);
+
+} // namespace psp
+} // namespace avp64
+
+#endif
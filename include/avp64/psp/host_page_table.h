@@ -0,0 +1,145 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef AVP64_PSP_HOST_PAGE_TABLE_H
+#define AVP64_PSP_HOST_PAGE_TABLE_H
+
+#include "avp64/common.h"
+
+namespace avp64 {
+namespace psp {
+
+class mem_protector_if;
+
+struct target_page_data {
+    mem_protector_if* c;
+    vcml::u64 page_addr;
+    vcml::u64 page_size;
+    void* host_address;
+};
+
+// target pages of a host page; the first INLINE_SLOTS entries are stored
+// inline, only pages shared by more target pages allocate memory
+class target_page_list
+{
+public:
+    static constexpr size_t INLINE_SLOTS = 4;
+
+    target_page_list(): m_inline(), m_size(0), m_spill() {}
+    target_page_list(target_page_list&&) = default;
+    target_page_list& operator=(target_page_list&&) = default;
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    target_page_data& operator[](size_t i) {
+        return i < INLINE_SLOTS ? m_inline[i] : (*m_spill)[i - INLINE_SLOTS];
+    }
+
+    const target_page_data& operator[](size_t i) const {
+        return i < INLINE_SLOTS ? m_inline[i] : (*m_spill)[i - INLINE_SLOTS];
+    }
+
+    void push_back(const target_page_data& tp);
+
+    template <typename PRED>
+    void remove_if(PRED pred);
+
+private:
+    array<target_page_data, INLINE_SLOTS> m_inline;
+    size_t m_size;
+    unique_ptr<vector<target_page_data>> m_spill;
+
+    void pop_back();
+};
+
+template <typename PRED>
+void target_page_list::remove_if(PRED pred) {
+    for (size_t i = 0; i < m_size;) {
+        if (!pred((*this)[i])) {
+            ++i;
+            continue;
+        }
+
+        // order does not matter, move the last entry into the gap
+        (*this)[i] = (*this)[m_size - 1];
+        pop_back();
+    }
+}
+
+struct host_page_data {
+    target_page_list target_pages;
+    bool locked;
+
+    host_page_data(): target_pages(), locked(false) {}
+};
+
+// open addressing hash table (linear probing) keyed by host page number;
+// lookups neither allocate nor chase pointers, so find() can be used from
+// within a signal handler
+class host_page_table
+{
+public:
+    explicit host_page_table(vcml::u64 page_bits);
+
+    host_page_table(const host_page_table&) = delete;
+    host_page_table& operator=(const host_page_table&) = delete;
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    // references are invalidated by subsequent calls to insert or erase
+    host_page_data* find(const void* page);
+    host_page_data& insert(const void* page);
+    bool erase(const void* page);
+    void clear();
+
+    // calls func(page, data) for every entry in unspecified order
+    template <typename FUNC>
+    void for_each(FUNC func) {
+        for (slot& s : m_slots) {
+            if (s.key != EMPTY)
+                func(reinterpret_cast<void*>(s.key << m_page_bits), s.data);
+        }
+    }
+
+private:
+    static constexpr vcml::u64 EMPTY = ~0ull;
+    static constexpr size_t MIN_CAPACITY = 64;
+
+    struct slot {
+        vcml::u64 key;
+        host_page_data data;
+
+        slot(): key(EMPTY), data() {}
+    };
+
+    vcml::u64 m_page_bits;
+    vector<slot> m_slots;
+    size_t m_mask;
+    size_t m_shift;
+    size_t m_size;
+
+    vcml::u64 key_of(const void* page) const {
+        return reinterpret_cast<vcml::u64>(page) >> m_page_bits;
+    }
+
+    size_t home(vcml::u64 key) const {
+        // fibonacci hashing spreads consecutive page numbers
+        return (key * 0x9e3779b97f4a7c15ull) >> m_shift;
+    }
+
+    size_t probe(vcml::u64 key) const;
+    void rehash(size_t capacity);
+};
+
+} // namespace psp
+} // namespace avp64
+
+#endif
@@ -0,0 +1,46 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef AVP64_PSP_IDLE_TRACKER_H
+#define AVP64_PSP_IDLE_TRACKER_H
+
+#include "avp64/common.h"
+
+#include <mutex>
+
+namespace avp64 {
+namespace psp {
+
+// tracks which cores of a cluster wait for interrupts and for how long the
+// cluster as a whole was idle; times are simulated picoseconds
+class idle_tracker
+{
+public:
+    explicit idle_tracker(size_t ncores);
+
+    void enter(size_t core, vcml::u64 now_ps);
+    void leave(size_t core, vcml::u64 now_ps);
+
+    vcml::u64 idle_periods() const;
+    vcml::u64 idle_time_ps() const;
+
+private:
+    mutable std::mutex m_mtx;
+    vector<bool> m_idle;
+    size_t m_num_idle;
+
+    vcml::u64 m_idle_since;
+    vcml::u64 m_idle_periods;
+    vcml::u64 m_idle_time;
+};
+
+} // namespace psp
+} // namespace avp64
+
+#endif
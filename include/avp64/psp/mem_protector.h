@@ -11,8 +11,14 @@
 #define AVP64_PSP_MEM_PROTECTOR_H
 
 #include "avp64/common.h"
+#include "avp64/psp/host_page_table.h"
+#include "avp64/psp/spin_lock.h"
 
+#include <atomic>
 #include <csignal>
+#include <map>
+#include <mutex>
+#include <thread>
 
 namespace avp64 {
 namespace psp {
@@ -24,36 +30,113 @@ public:
 
     virtual vcml::u64 page_size() = 0;
     virtual void update_page(vcml::u64 page_addr) = 0;
+
+    // called if only [start, end] of a target page was written, which
+    // happens when target pages span multiple host pages
+    virtual void update_page_range(vcml::u64 page_addr, vcml::u64 start,
+                                   vcml::u64 end) {
+        update_page(page_addr);
+    }
+
+    // called once per write fault on the first of the distinct owners that
+    // were notified, after all of them have been updated
+    virtual void page_written(mem_protector_if* const* owners, size_t n) {}
 };
 
 class mem_protector
 {
+public:
+    enum backend_kind {
+        BACKEND_SIGNAL = 0,      // mprotect + SIGSEGV handler
+        BACKEND_USERFAULTFD = 1, // userfaultfd write-protect mode
+    };
+
 private:
-    struct target_page_data {
-        mem_protector_if* c;
-        vcml::u64 page_addr;
-        vcml::u64 page_size;
+    struct target_page_ref {
         void* host_address;
+        vcml::u64 page_size;
+    };
+
+    class page_guard
+    {
+    private:
+        mem_protector& m_mp;
+
+    public:
+        explicit page_guard(mem_protector& mp): m_mp(mp) { m_mp.lock(); }
+        ~page_guard() { m_mp.unlock(); }
     };
-    struct host_page_data {
-        std::list<target_page_data> target_pages;
-        bool locked;
 
-        host_page_data(): target_pages(), locked(false) {}
+    struct page_run {
+        void* addr;
+        size_t npages;
     };
 
     static const vcml::u64 HOST_PAGE_BITS;
     static const vcml::u64 HOST_PAGE_MASK;
+    static constexpr size_t RECENT_RUNS = 64;
+
+    // guards all members below; the segfault handler takes it as well,
+    // which is safe since it is never held while accessing guest memory
+    spin_lock m_mtx;
+    std::atomic<std::thread::id> m_owner;
+
+    host_page_table m_protected_pages;
 
-    std::unordered_map<void*, struct host_page_data> m_protected_pages;
+    // secondary index: target page address -> host page, per core
+    std::unordered_map<mem_protector_if*, std::map<vcml::u64, target_page_ref>>
+        m_target_pages;
+
+    // recently unprotected pages, to tell racing faults from real ones
+    array<page_run, RECENT_RUNS> m_recent;
+    size_t m_recent_idx;
+
+    std::atomic<vcml::u64> m_num_mprotect;
+    std::atomic<vcml::u64> m_num_mprotect_saved;
+
+    backend_kind m_backend;
+    bool m_handler_installed;
     struct sigaction m_sa_orig;
 
+    int m_uffd;
+    int m_uffd_stop;
+    std::thread m_uffd_thread;
+
     mem_protector();
+    void lock();
+    void unlock();
+    bool locked_by_self() const;
+
+    void install_handler();
+    void remove_handler();
+    void forward_signal(int sig, siginfo_t* si, void* arg);
     void segfault_handler_int(int sig, siginfo_t* si, void*);
-    bool protect_page(void* addr);
-    bool unprotect_page(void* addr);
+
+    bool uffd_open();
+    void uffd_close();
+    void uffd_stop_thread();
+    void uffd_handler();
+    bool uffd_protect(void* addr, size_t npages, bool wp, bool wake = true);
+    void uffd_wake(void* addr, size_t npages);
+
+    bool protect_pages(void* addr, size_t npages = 1);
+    bool unprotect_pages(void* addr, size_t npages = 1, bool wake = true);
+    void unprotect_all(std::vector<void*>& pages);
+    void remember_unprotected(void* addr, size_t npages);
+    bool recently_unprotected(void* page_addr) const;
+
+    void register_page_locked(const target_page_data& tp,
+                              std::vector<void*>& protect);
+    void index_target_page(const target_page_data& tp);
+    void release_target_page(mem_protector_if* cpu, vcml::u64 page_addr,
+                             const target_page_ref& ref,
+                             std::vector<void*>& unprotect);
 
 public:
+    // target pages sharing one host page, notify_page copies them into a
+    // buffer of this size since it must not allocate memory
+    static constexpr size_t MAX_SHARED_PAGES = 64;
+
     static mem_protector& instance();
 
     mem_protector(const mem_protector&) = delete;
@@ -61,12 +144,32 @@ public:
     virtual ~mem_protector();
 
     static void segfault_handler(int sig, siginfo_t* si, void*);
+
+    // the backend can only be changed while no pages are protected; returns
+    // false if the requested backend is not supported by the host
+    bool set_backend(backend_kind backend);
+    backend_kind backend() const { return m_backend; }
+
+    // protects the page right away: the core executes its translations
+    // as soon as it returns, so the first write must already fault
     void register_page(mem_protector_if* cpu, vcml::u64 page_addr,
                        void* host_addr);
     void deregister_pages(mem_protector_if* cpu, vcml::u64 start,
                           vcml::u64 end);
     void deregister_page(mem_protector_if* cpu, vcml::u64 page_addr);
     bool notify_page(void* access_addr);
+
+    // the lock is held across fork() so that no other thread can leave it
+    // taken in the child, which then re-arms the protection it lost
+    void before_fork();
+    void after_fork(bool child);
+
+    vcml::u64 num_mprotect() const { return m_num_mprotect; }
+
+    // calls saved by merging contiguous host pages of large target pages,
+    // deregistered ranges and re-protection after fork; protections are
+    // never deferred, so pages of separate translations are not merged
+    vcml::u64 num_mprotect_saved() const { return m_num_mprotect_saved; }
 };
 
 } // namespace psp
@@ -0,0 +1,55 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef AVP64_PSP_OCX_LIBRARY_H
+#define AVP64_PSP_OCX_LIBRARY_H
+
+#include "avp64/common.h"
+#include "ocx/ocx.h"
+
+namespace avp64 {
+namespace psp {
+
+typedef ocx::core* (*create_instance_t)(ocx::u64, ocx::env&, const char*);
+typedef void (*delete_instance_t)(ocx::core*);
+
+// the OCX core library and its entry points, loaded once and shared by all
+// cores; it is unloaded when the last core releases it
+class ocx_library
+{
+public:
+    static shared_ptr<ocx_library> get();
+
+    // number of cores currently holding the library
+    static long users();
+
+    ~ocx_library();
+
+    ocx_library(const ocx_library&) = delete;
+    ocx_library& operator=(const ocx_library&) = delete;
+
+    ocx::core* create_instance(ocx::u64 version, ocx::env& env,
+                               const char* variant) const;
+    void delete_instance(ocx::core* core) const;
+
+private:
+    void* m_handle;
+    create_instance_t m_create_instance;
+    delete_instance_t m_delete_instance;
+
+    explicit ocx_library(const char* path);
+
+    template <typename T>
+    T lookup(const char* name);
+};
+
+} // namespace psp
+} // namespace avp64
+
+#endif
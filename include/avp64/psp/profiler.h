@@ -0,0 +1,63 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef AVP64_PSP_PROFILER_H
+#define AVP64_PSP_PROFILER_H
+
+#include "avp64/common.h"
+
+#include <functional>
+#include <map>
+#include <ostream>
+#include <unordered_map>
+
+namespace avp64 {
+namespace psp {
+
+// collects weighted guest call stacks; samples are staged in a fixed size
+// buffer and folded into the aggregated profile whenever it runs full
+class profiler
+{
+public:
+    static constexpr size_t MAX_DEPTH = 64;
+
+    typedef std::function<string(vcml::u64)> symbolizer;
+
+    explicit profiler(size_t capacity);
+
+    vcml::u64 num_samples() const { return m_num_samples; }
+    vcml::u64 total_weight() const { return m_total_weight; }
+
+    // frames[0] is the sampled pc, followed by the return addresses
+    void sample(vcml::u64 weight, const vcml::u64* frames, size_t depth);
+    void reset();
+
+    // flat profile: self weight per symbol, sorted by weight
+    void write_flat(std::ostream& os, const symbolizer& sym);
+
+    // folded stacks, root first, as consumed by flamegraph.pl
+    void write_folded(std::ostream& os, const symbolizer& sym);
+
+private:
+    vector<vcml::u64> m_buffer;
+    size_t m_used;
+
+    vcml::u64 m_num_samples;
+    vcml::u64 m_total_weight;
+
+    std::unordered_map<vcml::u64, vcml::u64> m_flat;
+    std::map<vector<vcml::u64>, vcml::u64> m_stacks;
+
+    void fold();
+};
+
+} // namespace psp
+} // namespace avp64
+
+#endif
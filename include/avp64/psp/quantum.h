@@ -0,0 +1,63 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef AVP64_PSP_QUANTUM_H
+#define AVP64_PSP_QUANTUM_H
+
+#include "avp64/common.h"
+
+namespace avp64 {
+namespace psp {
+
+// adapts the quantum of a core in cycles: it grows while the core runs
+// without MMIO, interrupt or timer activity and shrinks as soon as such
+// events cluster within a quantum
+class quantum_controller
+{
+public:
+    static constexpr size_t HISTOGRAM_SIZE = 64;
+    static constexpr vcml::u64 SHRINK_EVENTS = 2;
+    static constexpr vcml::u64 GROW_QUANTA = 4;
+
+    // quanta per power of two bucket, bucket i counts [2^i, 2^(i+1))
+    typedef array<vcml::u64, HISTOGRAM_SIZE> histogram;
+
+    quantum_controller();
+
+    // a zero max disables the controller
+    void configure(vcml::u64 min, vcml::u64 max);
+    bool enabled() const { return m_max > 0; }
+
+    vcml::u64 min() const { return m_min; }
+    vcml::u64 max() const { return m_max; }
+    vcml::u64 quantum() const { return m_quantum; }
+    const histogram& quanta() const { return m_histogram; }
+
+    void activity() { m_events++; }
+
+    // called after each quantum with the number of cycles it executed
+    void update(vcml::u64 cycles);
+
+    void reset();
+
+    static size_t bucket(vcml::u64 cycles);
+
+private:
+    vcml::u64 m_min;
+    vcml::u64 m_max;
+    vcml::u64 m_quantum;
+    vcml::u64 m_events;
+    vcml::u64 m_quiet;
+    histogram m_histogram;
+};
+
+} // namespace psp
+} // namespace avp64
+
+#endif
@@ -0,0 +1,127 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef AVP64_PSP_SNAPSHOT_H
+#define AVP64_PSP_SNAPSHOT_H
+
+#include "avp64/common.h"
+
+#include <map>
+#include <type_traits>
+
+namespace avp64 {
+namespace psp {
+
+// snapshot file: a header followed by named sections, each section is
+// stored as its name length, name, payload size and payload
+struct snapshot_header {
+    char magic[8];
+    vcml::u32 version;
+    vcml::u32 reserved;
+    vcml::u64 num_sections;
+};
+
+constexpr const char SNAPSHOT_MAGIC[8] = { 'A', 'V', 'P', '6',
+                                           '4', 'S', 'N', 'P' };
+constexpr vcml::u32 SNAPSHOT_VERSION = 2;
+
+// byte buffer with sequential readers and writers for the state of one
+// component of the platform
+class snapshot_section
+{
+public:
+    static constexpr size_t PAGE_SIZE = 4096;
+
+    snapshot_section();
+
+    const vector<vcml::u8>& data() const { return m_data; }
+    vector<vcml::u8>& data() { return m_data; }
+    size_t size() const { return m_data.size(); }
+
+    void rewind() { m_pos = 0; }
+    bool eof() const { return m_pos >= m_data.size(); }
+
+    void write(const void* src, size_t len);
+    void read(void* dest, size_t len);
+
+    template <typename T>
+    void put(const T& val) {
+        static_assert(std::is_trivially_copyable<T>::value, "invalid type");
+        write(&val, sizeof(val));
+    }
+
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable<T>::value, "invalid type");
+        T val;
+        read(&val, sizeof(val));
+        return val;
+    }
+
+    // strings are stored as their length followed by the characters
+    void put_str(const string& str);
+    string get_str();
+
+    // memory contents are stored page by page: zero pages only take one
+    // byte, all others are run length encoded unless that makes them larger
+    void write_pages(const vcml::u8* src, size_t len);
+    void read_pages(vcml::u8* dest, size_t len);
+
+    // number of zero pages skipped by write_pages
+    vcml::u64 zero_pages() const { return m_zero_pages; }
+
+private:
+    vector<vcml::u8> m_data;
+    size_t m_pos;
+    vcml::u64 m_zero_pages;
+};
+
+class snapshot
+{
+public:
+    snapshot();
+
+    bool empty() const { return m_sections.empty(); }
+    size_t num_sections() const { return m_sections.size(); }
+
+    bool has_section(const string& name) const;
+
+    // creates an empty section, replacing an existing one
+    snapshot_section& create(const string& name);
+
+    // returns the named section rewound to its start, errors if missing
+    snapshot_section& section(const string& name);
+
+    void save(const string& path) const;
+    void load(const string& path);
+
+private:
+    std::map<string, snapshot_section> m_sections;
+};
+
+// page encodings used by snapshot_section::write_pages
+enum snapshot_page : vcml::u8 {
+    SNAPSHOT_PAGE_ZERO = 0,
+    SNAPSHOT_PAGE_RAW = 1,
+    SNAPSHOT_PAGE_RLE = 2,
+};
+
+// run length encoding: a control byte c < 128 is followed by c + 1 literal
+// bytes, any other control byte by one byte repeated c - 125 times; encode
+// returns 0 if the result would exceed limit bytes, decode returns whether
+// src expands to exactly size bytes
+size_t snapshot_rle_encode(const vcml::u8* src, size_t len, vcml::u8* dest,
+                           size_t limit);
+bool snapshot_rle_decode(const vcml::u8* src, size_t len, vcml::u8* dest,
+                         size_t size);
+
+} // namespace psp
+} // namespace avp64
+
+#endif
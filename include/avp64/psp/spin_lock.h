@@ -0,0 +1,45 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef AVP64_PSP_SPIN_LOCK_H
+#define AVP64_PSP_SPIN_LOCK_H
+
+#include "avp64/common.h"
+
+#include <atomic>
+#include <sched.h>
+
+namespace avp64 {
+namespace psp {
+
+// lock that can be taken from within a signal handler, unlike std::mutex;
+// the handler must not interrupt a thread holding the same lock, so it is
+// only held across code that never touches protected memory
+class spin_lock
+{
+public:
+    spin_lock() = default;
+    spin_lock(const spin_lock&) = delete;
+    spin_lock& operator=(const spin_lock&) = delete;
+
+    void lock() {
+        while (m_flag.test_and_set(std::memory_order_acquire))
+            ::sched_yield();
+    }
+
+    void unlock() { m_flag.clear(std::memory_order_release); }
+
+private:
+    std::atomic_flag m_flag = ATOMIC_FLAG_INIT;
+};
+
+} // namespace psp
+} // namespace avp64
+
+#endif
@@ -0,0 +1,101 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef AVP64_PSP_TIMER_WHEEL_H
+#define AVP64_PSP_TIMER_WHEEL_H
+
+#include "avp64/common.h"
+
+#include <functional>
+
+namespace avp64 {
+namespace psp {
+
+// absolute deadlines in picoseconds of a small, fixed set of timers; the
+// earliest one is cached so that reprogramming any other timer is cheap
+class timer_wheel
+{
+public:
+    static constexpr vcml::u64 NONE = ~0ull;
+
+    explicit timer_wheel(size_t ntimers = 0);
+
+    // adds n timers and returns the index of the first one
+    size_t add_timers(size_t n);
+    size_t size() const { return m_deadlines.size(); }
+
+    vcml::u64 deadline(size_t timer) const { return m_deadlines.at(timer); }
+    vcml::u64 next() const { return m_next; }
+
+    // both return whether the earliest deadline changed
+    bool schedule(size_t timer, vcml::u64 deadline_ps);
+    bool cancel(size_t timer);
+
+    // removes all timers due at now_ps and calls func for each of them in
+    // ascending index order; func may schedule timers again
+    size_t expire(vcml::u64 now_ps, const std::function<void(size_t)>& func);
+
+private:
+    vector<vcml::u64> m_deadlines;
+    vcml::u64 m_next;
+
+    void update_next();
+};
+
+// dispatches the timers of all cores of a cluster from a single SystemC
+// method that is only notified for the earliest deadline
+class timer_dispatcher
+{
+public:
+    typedef std::function<void(size_t)> handler;
+
+    timer_dispatcher();
+
+    timer_dispatcher(const timer_dispatcher&) = delete;
+    timer_dispatcher& operator=(const timer_dispatcher&) = delete;
+
+    // returns the index of the first timer of the client, handlers are
+    // called with the timer index relative to it
+    size_t add_client(size_t ntimers, const handler& func);
+
+    void schedule(size_t timer, vcml::u64 deadline_ps);
+    void cancel(size_t timer);
+
+    vcml::u64 deadline(size_t timer) const { return m_wheel.deadline(timer); }
+
+    // spawns the dispatch method, must be called during elaboration
+    void start(const char* name);
+
+    vcml::u64 num_dispatched() const { return m_num_dispatched; }
+    vcml::u64 num_rescheduled() const { return m_num_rescheduled; }
+
+private:
+    struct client {
+        size_t first;
+        handler func;
+    };
+
+    timer_wheel m_wheel;
+    vector<client> m_clients;
+    vector<size_t> m_owner;
+
+    sc_core::sc_event m_event;
+    vcml::u64 m_scheduled;
+
+    vcml::u64 m_num_dispatched;
+    vcml::u64 m_num_rescheduled;
+
+    void dispatch();
+    void reschedule();
+};
+
+} // namespace psp
+} // namespace avp64
+
+#endif
@@ -0,0 +1,78 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef AVP64_PSP_WORKER_H
+#define AVP64_PSP_WORKER_H
+
+#include "avp64/common.h"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace avp64 {
+namespace psp {
+
+// runs jobs on a dedicated, optionally pinned host thread; the job can hand
+// work back to the thread waiting in finish(), which executes it in between
+class worker
+{
+public:
+    typedef std::function<void()> function;
+
+    // host_cpu < 0 leaves the thread unpinned
+    explicit worker(int host_cpu = -1);
+    ~worker();
+
+    worker(const worker&) = delete;
+    worker& operator=(const worker&) = delete;
+
+    bool on_worker() const {
+        return std::this_thread::get_id() == m_thread.get_id();
+    }
+
+    void start(function job);
+
+    // serves calls of the running job until it is done, exceptions thrown
+    // by the job are rethrown here
+    void finish();
+
+    // executes func on the thread waiting in finish() and blocks until it is
+    // done; exceptions thrown by func are rethrown on the worker thread
+    void call(const function& func);
+
+    vcml::u64 num_jobs() const { return m_num_jobs; }
+    vcml::u64 num_calls() const { return m_num_calls; }
+
+private:
+    std::mutex m_mtx;
+    std::condition_variable m_cv_worker;
+    std::condition_variable m_cv_caller;
+
+    function m_job;
+    const function* m_call;
+    bool m_busy;
+    bool m_stop;
+    std::exception_ptr m_job_error;
+    std::exception_ptr m_call_error;
+
+    vcml::u64 m_num_jobs;
+    vcml::u64 m_num_calls;
+
+    std::thread m_thread;
+
+    void run(int host_cpu);
+};
+
+} // namespace psp
+} // namespace avp64
+
+#endif
@@ -113,6 +113,10 @@ public:
     vcml::property<int> irq_can1;
     vcml::property<int> irq_virtio0;
 
+    // skips the framebuffer devices, their memory stays accessible; only
+    // avp64 has them, avp64_minimal needs no such property
+    vcml::property<bool> headless;
+
     explicit system(const sc_core::sc_module_name& name);
     system() = delete;
     system(const system&) = delete;
@@ -128,16 +132,16 @@ public:
 
 private:
     vcml::generic::clock m_clock_cpu;
-    vcml::generic::clock m_fb0fps;
-    vcml::generic::clock m_fb1fps;
+    unique_ptr<vcml::generic::clock> m_fb0fps;
+    unique_ptr<vcml::generic::clock> m_fb1fps;
     vcml::generic::reset m_reset;
     vcml::meta::throttle m_throttle;
 
     vcml::generic::bus m_bus;
     vcml::generic::memory m_ram;
-    vcml::generic::fbdev m_fb0;
+    unique_ptr<vcml::generic::fbdev> m_fb0;
     vcml::generic::memory m_fb0mem;
-    vcml::generic::fbdev m_fb1;
+    unique_ptr<vcml::generic::fbdev> m_fb1;
     vcml::generic::memory m_fb1mem;
     vcml::serial::pl011 m_uart0;
     vcml::serial::pl011 m_uart1;
@@ -197,16 +201,17 @@ system::system(const sc_core::sc_module_name& nm):
     irq_can0("irq_can0", SPI_CAN_0),
     irq_can1("irq_can1", SPI_CAN_1),
     irq_virtio0("irq_virtio0", SPI_VIRTIO0),
+    headless("headless", false),
     m_clock_cpu("clock_cpu", 1 * mwr::GHz),
-    m_fb0fps("fb0fps", 60 * mwr::Hz),
-    m_fb1fps("fb1fps", 60 * mwr::Hz),
+    m_fb0fps(),
+    m_fb1fps(),
     m_reset("reset"),
     m_throttle("throttle"),
     m_bus("bus"),
     m_ram("ram", addr_ram.get().length()),
-    m_fb0("fb0"),
+    m_fb0(),
     m_fb0mem("fb0_mem", addr_fb0mem.get().length()),
-    m_fb1("fb1"),
+    m_fb1(),
     m_fb1mem("fb1_mem", addr_fb1mem.get().length()),
     m_uart0("uart0"),
     m_uart1("uart1"),
@@ -255,14 +260,9 @@ system::system(const sc_core::sc_module_name& nm):
     clk_bind(m_clock_cpu, "clk", m_can_msgram, "clk");
     clk_bind(m_clock_cpu, "clk", m_virtio0, "clk");
 
-    clk_bind(m_fb0fps, "clk", m_fb0, "clk");
-    clk_bind(m_fb1fps, "clk", m_fb1, "clk");
-
     gpio_bind(m_reset, "rst", m_bus, "rst");
     gpio_bind(m_reset, "rst", m_ram, "rst");
-    gpio_bind(m_reset, "rst", m_fb0, "rst");
     gpio_bind(m_reset, "rst", m_fb0mem, "rst");
-    gpio_bind(m_reset, "rst", m_fb1, "rst");
     gpio_bind(m_reset, "rst", m_fb1mem, "rst");
     gpio_bind(m_reset, "rst", m_uart0, "rst");
     gpio_bind(m_reset, "rst", m_uart1, "rst");
@@ -283,9 +283,7 @@ system::system(const sc_core::sc_module_name& nm):
 
     tlm_bind(m_bus, m_cpu, "bus");
     tlm_bind(m_bus, m_ram, "in", addr_ram);
-    tlm_bind(m_bus, m_fb0, "out");
     tlm_bind(m_bus, m_fb0mem, "in", addr_fb0mem);
-    tlm_bind(m_bus, m_fb1, "out");
     tlm_bind(m_bus, m_fb1mem, "in", addr_fb1mem);
     tlm_bind(m_bus, m_uart0, "in", addr_uart0);
     tlm_bind(m_bus, m_uart1, "in", addr_uart1);
@@ -347,11 +345,59 @@ system::system(const sc_core::sc_module_name& nm):
 
     // VIRTIO
     virtio_bind(m_virtio0, "virtio_out", m_virtio_input, "virtio_in");
+
+    // Framebuffers
+    if (!headless) {
+        m_fb0fps = std::make_unique<vcml::generic::clock>("fb0fps",
+                                                          60 * mwr::Hz);
+        m_fb1fps = std::make_unique<vcml::generic::clock>("fb1fps",
+                                                          60 * mwr::Hz);
+        m_fb0 = std::make_unique<vcml::generic::fbdev>("fb0");
+        m_fb1 = std::make_unique<vcml::generic::fbdev>("fb1");
+
+        clk_bind(*m_fb0fps, "clk", *m_fb0, "clk");
+        clk_bind(*m_fb1fps, "clk", *m_fb1, "clk");
+        gpio_bind(m_reset, "rst", *m_fb0, "rst");
+        gpio_bind(m_reset, "rst", *m_fb1, "rst");
+        tlm_bind(m_bus, *m_fb0, "out");
+        tlm_bind(m_bus, *m_fb1, "out");
+    }
+
+    // Guest memory for snapshots and reports
+    m_cpu.add_guest_memory(addr_ram);
+    m_cpu.add_guest_memory(addr_fb0mem);
+    m_cpu.add_guest_memory(addr_fb1mem);
+    m_cpu.add_guest_memory(addr_can_msgram);
+
+    // Device registers for snapshots
+    m_cpu.add_snapshot_device(m_uart0);
+    m_cpu.add_snapshot_device(m_uart1);
+    m_cpu.add_snapshot_device(m_uart2);
+    m_cpu.add_snapshot_device(m_uart3);
+    m_cpu.add_snapshot_device(m_lan0);
+    m_cpu.add_snapshot_device(m_sdhci);
+    m_cpu.add_snapshot_device(m_simdev);
+    m_cpu.add_snapshot_device(m_hwrng);
+    m_cpu.add_snapshot_device(m_spi);
+    m_cpu.add_snapshot_device(m_gpio);
+    m_cpu.add_snapshot_device(m_rtc);
+    m_cpu.add_snapshot_device(m_can);
+    m_cpu.add_snapshot_device(m_virtio0);
+
+    // Devices with state outside of their registers
+    m_cpu.add_uncaptured_device(m_lan0);
+    m_cpu.add_uncaptured_device(m_sdcard);
+    m_cpu.add_uncaptured_device(m_sdhci);
+    m_cpu.add_uncaptured_device(m_can);
+    m_cpu.add_uncaptured_device(m_virtio0);
+    m_cpu.add_uncaptured_device(m_virtio_input);
 }
 
 int system::run() {
     double simstart = mwr::timestamp();
     int result = vcml::system::run();
+    if (m_cpu.failed_children() > 0)
+        result = EXIT_FAILURE;
     double realtime = mwr::timestamp() - simstart;
     double duration = sc_core::sc_time_stamp().to_seconds();
     vcml::u64 ninsn = m_cpu.cycle_count();
@@ -170,11 +170,29 @@ system::system(const sc_core::sc_module_name& nm):
     gpio_bind(m_uart0, "irq", m_cpu, "spi", irq_uart0);
     gpio_bind(m_lan0, "irq", m_cpu, "spi", irq_lan0);
     gpio_bind(m_sdhci, "irq", m_cpu, "spi", irq_sdhci);
+
+    // Guest memory for snapshots and reports
+    m_cpu.add_guest_memory(addr_ram);
+
+    // Device registers for snapshots
+    m_cpu.add_snapshot_device(m_uart0);
+    m_cpu.add_snapshot_device(m_lan0);
+    m_cpu.add_snapshot_device(m_sdhci);
+    m_cpu.add_snapshot_device(m_simdev);
+    m_cpu.add_snapshot_device(m_hwrng);
+    m_cpu.add_snapshot_device(m_rtc);
+
+    // Devices with state outside of their registers
+    m_cpu.add_uncaptured_device(m_lan0);
+    m_cpu.add_uncaptured_device(m_sdcard);
+    m_cpu.add_uncaptured_device(m_sdhci);
 }
 
 int system::run() {
     double simstart = mwr::timestamp();
     int result = vcml::system::run();
+    if (m_cpu.failed_children() > 0)
+        result = EXIT_FAILURE;
     double realtime = mwr::timestamp() - simstart;
     double duration = sc_core::sc_time_stamp().to_seconds();
     vcml::u64 ninsn = m_cpu.cycle_count();
@@ -0,0 +1,51 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/bb_trace.h"
+
+#include <cstdio>
+#include <map>
+
+// decodes binary basic block traces written by avp64 cores, either as one
+// "time_ps vaddr" line per block or as execution counts per block address
+int main(int argc, char** argv) {
+    bool counts = argc == 3 && std::strcmp(argv[1], "-c") == 0;
+    if (argc != 2 && !counts) {
+        std::fprintf(stderr, "usage: %s [-c] <trace.bin>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        avp64::psp::bb_trace_reader reader(argv[argc - 1]);
+        std::map<vcml::u64, vcml::u64> blocks;
+
+        vcml::u64 vaddr, time_ps;
+        while (reader.next(vaddr, time_ps)) {
+            if (counts) {
+                blocks[vaddr]++;
+                continue;
+            }
+
+            std::printf("%llu 0x%016llx\n",
+                        static_cast<unsigned long long>(time_ps),
+                        static_cast<unsigned long long>(vaddr));
+        }
+
+        for (const auto& [addr, n] : blocks) {
+            std::printf("0x%016llx %llu\n",
+                        static_cast<unsigned long long>(addr),
+                        static_cast<unsigned long long>(n));
+        }
+    } catch (std::exception& ex) {
+        std::fprintf(stderr, "%s\n", ex.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
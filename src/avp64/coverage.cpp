@@ -0,0 +1,62 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/coverage.h"
+
+#include <cstdio>
+#include <cstring>
+
+// unions coverage files of multiple simulation runs, optionally writing the
+// result to a new coverage file or listing all covered block addresses
+static int usage(const char* name) {
+    std::fprintf(stderr, "usage: %s [-l] [-o <out.cov>] <in.cov>...\n", name);
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char** argv) {
+    const char* output = nullptr;
+    bool list = false;
+    int idx = 1;
+
+    for (; idx < argc && argv[idx][0] == '-'; ++idx) {
+        if (std::strcmp(argv[idx], "-l") == 0)
+            list = true;
+        else if (std::strcmp(argv[idx], "-o") == 0 && idx + 1 < argc)
+            output = argv[++idx];
+        else
+            return usage(argv[0]);
+    }
+
+    if (idx == argc)
+        return usage(argv[0]);
+
+    try {
+        avp64::psp::coverage_map total;
+        for (; idx < argc; ++idx)
+            total.load(argv[idx]);
+
+        if (output)
+            total.save(output);
+
+        if (list) {
+            total.for_each([](vcml::u64 addr) {
+                std::printf("0x%016llx\n",
+                            static_cast<unsigned long long>(addr));
+            });
+        } else {
+            std::printf("%zu blocks in %zu pages\n", total.count(),
+                        total.num_pages());
+        }
+    } catch (std::exception& ex) {
+        std::fprintf(stderr, "%s\n", ex.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,267 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/bb_trace.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace avp64 {
+namespace psp {
+
+constexpr size_t FILE_CHUNK = 16ull << 20;
+
+static size_t put_varint(vcml::u8* buf, vcml::u64 val) {
+    size_t n = 0;
+    while (val >= 0x80) {
+        buf[n++] = static_cast<vcml::u8>(val) | 0x80;
+        val >>= 7;
+    }
+
+    buf[n++] = static_cast<vcml::u8>(val);
+    return n;
+}
+
+// maps small negative deltas to small positive numbers
+static vcml::u64 zigzag(vcml::u64 delta) {
+    vcml::u64 sign = static_cast<vcml::u64>(static_cast<int64_t>(delta) >> 63);
+    return (delta << 1) ^ sign;
+}
+
+static vcml::u64 unzigzag(vcml::u64 val) {
+    return (val >> 1) ^ (0 - (val & 1));
+}
+
+bb_trace_writer::bb_trace_writer(const string& path, vcml::u64 core_id,
+                                 size_t ring_size):
+    m_ring(),
+    m_mask(0),
+    m_head(0),
+    m_tail(0),
+    m_prev_vaddr(0),
+    m_prev_time(0),
+    m_num_records(0),
+    m_fd(-1),
+    m_map(nullptr),
+    m_map_size(0),
+    m_file_pos(0),
+    m_stop(false),
+    m_thread() {
+    size_t size = 1;
+    while (size < std::max(ring_size, 4 * MAX_RECORD_SIZE))
+        size <<= 1;
+
+    m_ring.resize(size);
+    m_mask = size - 1;
+
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    VCML_ERROR_ON(m_fd < 0, "cannot open trace file '%s': %s", path.c_str(),
+                  std::strerror(errno));
+
+    bb_trace_header hdr = {};
+    std::memcpy(hdr.magic, BB_TRACE_MAGIC, sizeof(hdr.magic));
+    hdr.version = BB_TRACE_VERSION;
+    hdr.core_id = core_id;
+    write_out(reinterpret_cast<const vcml::u8*>(&hdr), sizeof(hdr));
+
+    m_thread = std::thread(&bb_trace_writer::writer, this);
+}
+
+bb_trace_writer::~bb_trace_writer() {
+    string error;
+    if (!close_file(error))
+        mwr::log_error("%s", error.c_str());
+}
+
+void bb_trace_writer::record(vcml::u64 vaddr, vcml::u64 time_ps) {
+    vcml::u8 buf[MAX_RECORD_SIZE];
+    size_t n = put_varint(buf, zigzag(vaddr - m_prev_vaddr));
+    n += put_varint(buf + n, time_ps - m_prev_time);
+    m_prev_vaddr = vaddr;
+    m_prev_time = time_ps;
+    m_num_records++;
+
+    size_t head = m_head.load(std::memory_order_relaxed);
+    while (head + n - m_tail.load(std::memory_order_acquire) > m_ring.size())
+        std::this_thread::yield();
+
+    for (size_t i = 0; i < n; ++i)
+        m_ring[(head + i) & m_mask] = buf[i];
+
+    m_head.store(head + n, std::memory_order_release);
+}
+
+void bb_trace_writer::close() {
+    string error;
+    VCML_ERROR_ON(!close_file(error), "%s", error.c_str());
+}
+
+bool bb_trace_writer::close_file(string& error) {
+    if (m_fd < 0)
+        return true;
+
+    m_stop = true;
+    if (m_thread.joinable())
+        m_thread.join();
+
+    if (m_map && ::munmap(m_map, m_map_size) != 0)
+        error = mwr::mkstr("cannot unmap trace file: %s", std::strerror(errno));
+    if (::ftruncate(m_fd, m_file_pos) != 0 && error.empty())
+        error = mwr::mkstr("cannot truncate trace file: %s",
+                           std::strerror(errno));
+
+    ::close(m_fd);
+    m_fd = -1;
+    m_map = nullptr;
+    m_map_size = 0;
+    return error.empty();
+}
+
+void bb_trace_writer::suspend() {
+    m_stop = true;
+    if (m_thread.joinable())
+        m_thread.join();
+    m_stop = false;
+}
+
+void bb_trace_writer::resume() {
+    if (m_fd >= 0 && !m_thread.joinable())
+        m_thread = std::thread(&bb_trace_writer::writer, this);
+}
+
+void bb_trace_writer::discard() {
+    suspend();
+    if (m_map)
+        ::munmap(m_map, m_map_size);
+    if (m_fd >= 0)
+        ::close(m_fd);
+
+    m_fd = -1;
+    m_map = nullptr;
+    m_map_size = 0;
+}
+
+void bb_trace_writer::writer() {
+    while (!m_stop) {
+        if (m_head.load(std::memory_order_acquire) ==
+            m_tail.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+
+        drain();
+    }
+
+    drain();
+}
+
+void bb_trace_writer::drain() {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    size_t head = m_head.load(std::memory_order_acquire);
+    while (tail != head) {
+        size_t pos = tail & m_mask;
+        size_t n = std::min(head - tail, m_ring.size() - pos);
+        write_out(m_ring.data() + pos, n);
+        tail += n;
+    }
+
+    m_tail.store(tail, std::memory_order_release);
+}
+
+void bb_trace_writer::write_out(const vcml::u8* data, size_t n) {
+    if (m_file_pos + n > m_map_size) {
+        size_t size = m_map_size + std::max(n, FILE_CHUNK);
+        if (m_map)
+            ::munmap(m_map, m_map_size);
+
+        VCML_ERROR_ON(::ftruncate(m_fd, size) != 0,
+                      "cannot grow trace file: %s", std::strerror(errno));
+        void* map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                           m_fd, 0);
+        VCML_ERROR_ON(map == MAP_FAILED, "cannot map trace file: %s",
+                      std::strerror(errno));
+
+        m_map = static_cast<vcml::u8*>(map);
+        m_map_size = size;
+    }
+
+    std::memcpy(m_map + m_file_pos, data, n);
+    m_file_pos += n;
+}
+
+bb_trace_reader::bb_trace_reader(const string& path):
+    m_map(nullptr),
+    m_size(0),
+    m_pos(sizeof(bb_trace_header)),
+    m_core_id(0),
+    m_vaddr(0),
+    m_time(0) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    VCML_ERROR_ON(fd < 0, "cannot open trace file '%s': %s", path.c_str(),
+                  std::strerror(errno));
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(bb_trace_header)) {
+        ::close(fd);
+        VCML_ERROR("invalid trace file '%s'", path.c_str());
+    }
+
+    m_size = st.st_size;
+    void* map = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    VCML_ERROR_ON(map == MAP_FAILED, "cannot map trace file: %s",
+                  std::strerror(errno));
+    m_map = static_cast<vcml::u8*>(map);
+
+    bb_trace_header hdr;
+    std::memcpy(&hdr, m_map, sizeof(hdr));
+    if (std::memcmp(hdr.magic, BB_TRACE_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.version != BB_TRACE_VERSION) {
+        ::munmap(m_map, m_size);
+        VCML_ERROR("'%s' is not a basic block trace", path.c_str());
+    }
+
+    m_core_id = hdr.core_id;
+}
+
+bb_trace_reader::~bb_trace_reader() {
+    if (m_map)
+        ::munmap(m_map, m_size);
+}
+
+bool bb_trace_reader::read_varint(vcml::u64& val) {
+    val = 0;
+    for (unsigned int shift = 0; m_pos < m_size && shift < 64; shift += 7) {
+        vcml::u8 byte = m_map[m_pos++];
+        val |= static_cast<vcml::u64>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+
+    return false;
+}
+
+bool bb_trace_reader::next(vcml::u64& vaddr, vcml::u64& time_ps) {
+    vcml::u64 addr_delta, time_delta;
+    if (!read_varint(addr_delta) || !read_varint(time_delta))
+        return false;
+
+    m_vaddr += unzigzag(addr_delta);
+    m_time += time_delta;
+    vaddr = m_vaddr;
+    time_ps = m_time;
+    return true;
+}
+
+} // namespace psp
+} // namespace avp64
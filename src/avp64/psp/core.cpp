@@ -9,9 +9,9 @@
 
 #include "avp64/psp/core.h"
 
-#include "avp64/psp/systemc.h"
-
-#include <dlfcn.h>
+#include <algorithm>
+#include <fstream>
+#include <sys/mman.h>
 
 namespace avp64 {
 namespace psp {
@@ -19,14 +19,161 @@ namespace psp {
 constexpr const char* CPU_ARCH = "aarch64";
 constexpr const char* CPU_VARIANT = "Cortex-A72";
 
+ocx::u8* core::lookup_dmi_mru(dmi_direction dir, vcml::u64 page_paddr) {
+    auto& mru = m_dmi_mru[dir];
+    for (size_t i = 0; i < mru.size(); ++i) {
+        if (!mru[i].valid)
+            continue;
+
+        vcml::u64 page_end = page_paddr + mru[i].page_size - 1;
+        if (page_paddr < mru[i].start || page_end > mru[i].end)
+            continue;
+
+        if (i > 0)
+            std::rotate(mru.begin(), mru.begin() + i, mru.begin() + i + 1);
+
+        m_regions[mru[0].stats].dmi_hits++;
+        return mru[0].ptr + page_paddr - mru[0].start;
+    }
+
+    return nullptr;
+}
+
+void core::insert_dmi_mru(dmi_direction dir, const tlm::tlm_dmi& dmi,
+                          vcml::u64 page_size) {
+    auto& mru = m_dmi_mru[dir];
+    std::rotate(mru.begin(), mru.end() - 1, mru.end());
+    mru[0] = { true, dmi.get_start_address(), dmi.get_end_address(),
+               dmi.get_dmi_ptr(), page_size, find_dmi_region(dmi) };
+}
+
+bool core::lookup_no_dmi(dmi_direction dir, vcml::u64 page_paddr) const {
+    for (vcml::u64 page : m_no_dmi[dir]) {
+        if (page == page_paddr)
+            return true;
+    }
+
+    return false;
+}
+
+void core::insert_no_dmi(dmi_direction dir, vcml::u64 page_paddr) {
+    m_no_dmi[dir][m_no_dmi_idx[dir]] = page_paddr;
+    m_no_dmi_idx[dir] = (m_no_dmi_idx[dir] + 1) % NO_DMI_SIZE;
+}
+
+void core::flush_no_dmi(vcml::u64 start, vcml::u64 end) {
+    // pages that become DMI-able are announced via invalidate_dmi as well
+    for (auto& pages : m_no_dmi) {
+        for (vcml::u64& page : pages) {
+            if (page >= start && page <= end)
+                page = ~0ull;
+        }
+    }
+}
+
+void core::flush_dmi_mru(vcml::u64 start, vcml::u64 end) {
+    for (auto& mru : m_dmi_mru) {
+        for (auto& region : mru) {
+            if (region.valid && region.start <= end && region.end >= start)
+                region = {};
+        }
+    }
+}
+
+core::region_stats* core::find_region(vcml::u64 addr) {
+    auto it = std::upper_bound(m_region_index.begin(), m_region_index.end(),
+                               addr, [&](vcml::u64 a, size_t idx) {
+                                   return a < m_regions[idx].addr.start;
+                               });
+    if (it == m_region_index.begin())
+        return nullptr;
+
+    region_stats& region = m_regions[*(it - 1)];
+    return addr <= region.addr.end ? &region : nullptr;
+}
+
+size_t core::find_dmi_region(const tlm::tlm_dmi& dmi) {
+    for (size_t i = 0; i < m_regions.size(); ++i) {
+        const auto& region = m_regions[i];
+        if (!region.posted && region.addr.start == dmi.get_start_address() &&
+            region.addr.end == dmi.get_end_address()) {
+            return i;
+        }
+    }
+
+    vcml::range addr(dmi.get_start_address(), dmi.get_end_address());
+    return insert_region({ addr, false, 0, 0, 0 });
+}
+
+size_t core::insert_region(const region_stats& region) {
+    size_t idx = m_regions.size();
+    m_regions.push_back(region);
+
+    auto it = std::upper_bound(m_region_index.begin(), m_region_index.end(),
+                               region.addr.start, [&](vcml::u64 a, size_t i) {
+                                   return a < m_regions[i].addr.start;
+                               });
+    m_region_index.insert(it, idx);
+    return idx;
+}
+
+void core::post_write(const ocx::transaction& tx, size_t sbi) {
+    if (m_num_posted == m_posted.size())
+        flush_posted_writes();
+
+    posted_write& pw = m_posted[m_num_posted++];
+    pw.addr = tx.addr;
+    pw.size = tx.size;
+    pw.sbi = sbi;
+    std::copy_n(tx.data, tx.size, pw.data.begin());
+}
+
+void core::flush_posted_writes() {
+    for (size_t i = 0; i < m_num_posted; ++i) {
+        posted_write& pw = m_posted[i];
+        m_transport = true;
+        tlm::tlm_response_status resp = data.write(pw.addr, pw.data.data(),
+                                                   pw.size, m_sbi[pw.sbi]);
+        m_transport = false;
+
+        if (resp != tlm::TLM_OK_RESPONSE) {
+            log_error("posted write of %zu bytes to 0x%llx failed", pw.size,
+                      pw.addr);
+            if (m_posted_error == tlm::TLM_OK_RESPONSE)
+                m_posted_error = resp;
+        }
+    }
+
+    m_num_posted = 0;
+}
+
 ocx::u8* core::get_page_ptr_r(ocx::u64 page_paddr) {
+    if (m_has_dmi_flushes)
+        drain_dmi_flushes();
+
+    m_stats.dmi_requests++;
+    if (ocx::u8* ptr = lookup_dmi_mru(DMI_READ, page_paddr))
+        return ptr;
+
+    if (lookup_no_dmi(DMI_READ, page_paddr))
+        return nullptr;
+
+    if (on_worker()) {
+        ocx::u8* ptr = nullptr;
+        m_stats.dmi_requests--;
+        sc_call([&]() { ptr = get_page_ptr_r(page_paddr); });
+        return ptr;
+    }
+
     tlm::tlm_dmi dmi;
     vcml::u64 target_page_size = page_size();
     if (insn.dmi_cache().lookup(page_paddr, target_page_size,
                                 tlm::TLM_READ_COMMAND, dmi)) {
+        insert_dmi_mru(DMI_READ, dmi, target_page_size);
         return dmi.get_dmi_ptr() + page_paddr - dmi.get_start_address();
     }
 
+    m_stats.dmi_misses++;
     tlm::tlm_generic_payload tx;
     tx.set_address(page_paddr);
     tx.set_streaming_width(target_page_size);
@@ -34,19 +181,42 @@ ocx::u8* core::get_page_ptr_r(ocx::u64 page_paddr) {
     tx.set_read();
     if (insn->get_direct_mem_ptr(tx, dmi)) {
         insn.map_dmi(dmi);
+        advise_hugepages(dmi);
+        insert_dmi_mru(DMI_READ, dmi, target_page_size);
         return dmi.get_dmi_ptr() + page_paddr - dmi.get_start_address();
     }
+
+    insert_no_dmi(DMI_READ, page_paddr);
     return nullptr;
 }
 
 ocx::u8* core::get_page_ptr_w(ocx::u64 page_paddr) {
+    if (m_has_dmi_flushes)
+        drain_dmi_flushes();
+
+    m_stats.dmi_requests++;
+    if (ocx::u8* ptr = lookup_dmi_mru(DMI_WRITE, page_paddr))
+        return ptr;
+
+    if (lookup_no_dmi(DMI_WRITE, page_paddr))
+        return nullptr;
+
+    if (on_worker()) {
+        ocx::u8* ptr = nullptr;
+        m_stats.dmi_requests--;
+        sc_call([&]() { ptr = get_page_ptr_w(page_paddr); });
+        return ptr;
+    }
+
     tlm::tlm_dmi dmi;
     vcml::u64 target_page_size = page_size();
     if (insn.dmi_cache().lookup(page_paddr, target_page_size,
                                 tlm::TLM_WRITE_COMMAND, dmi)) {
+        insert_dmi_mru(DMI_WRITE, dmi, target_page_size);
         return dmi.get_dmi_ptr() + page_paddr - dmi.get_start_address();
     }
 
+    m_stats.dmi_misses++;
     tlm::tlm_generic_payload tx;
     tx.set_address(page_paddr);
     tx.set_streaming_width(target_page_size);
@@ -54,38 +224,109 @@ ocx::u8* core::get_page_ptr_w(ocx::u64 page_paddr) {
     tx.set_write();
     if (insn->get_direct_mem_ptr(tx, dmi)) {
         insn.map_dmi(dmi);
+        advise_hugepages(dmi);
+        insert_dmi_mru(DMI_WRITE, dmi, target_page_size);
         return dmi.get_dmi_ptr() + page_paddr - dmi.get_start_address();
     }
+
+    insert_no_dmi(DMI_WRITE, page_paddr);
     return nullptr;
 }
 
+void core::advise_hugepages(const tlm::tlm_dmi& dmi) {
+    if (!hugepages)
+        return;
+
+    // only the huge page aligned part of the region can be backed by
+    // transparent huge pages; protected code pages are tracked at host page
+    // granularity, the kernel splits the affected huge page on mprotect
+    const vcml::u64 huge_page_size = 2ull << 20;
+    vcml::u64 start = reinterpret_cast<vcml::u64>(dmi.get_dmi_ptr());
+    vcml::u64 end = start + dmi.get_end_address() - dmi.get_start_address();
+    start = (start + huge_page_size - 1) & ~(huge_page_size - 1);
+    end = (end + 1) & ~(huge_page_size - 1);
+    if (start >= end)
+        return;
+
+    if (::madvise(reinterpret_cast<void*>(start), end - start,
+                  MADV_HUGEPAGE) != 0) {
+        log_debug("madvise: %s", std::strerror(errno));
+    }
+}
+
 void core::invalidate_dmi(vcml::u64 start, vcml::u64 end) {
     vcml::processor::invalidate_dmi(start, end);
 
-    dynamic_cast<ocx::core_inv_range_extension*>(m_core)->invalidate_page_ptrs(
-        start, end);
+    // the DMI caches and the page pointers of the OCX core belong to the
+    // thread executing the core
+    if (m_thread != std::this_thread::get_id()) {
+        std::lock_guard<std::mutex> guard(m_dmi_flush_mtx);
+        m_dmi_flushes.push_back({ start, end });
+        m_has_dmi_flushes = true;
+    } else {
+        flush_dmi_mru(start, end);
+        flush_no_dmi(start, end);
+        m_inv_range->invalidate_page_ptrs(start, end);
+    }
+
     mem_protector::instance().deregister_pages(this, start, end);
 }
 
 void core::protect_page(ocx::u8* page_ptr, ocx::u64 page_addr) {
+    // QEMU protects a page again without it being written when it dropped
+    // all translations by itself, which it does once its cache is full
+    drain_written_pages();
+    if (m_code_pages.insert(page_addr).second)
+        m_stats.code_pages++;
+    else
+        m_stats.code_pages_retranslated++;
+
     mem_protector::instance().register_page(this, page_addr, page_ptr);
 }
 
 ocx::response core::transport(const ocx::transaction& tx) {
-    m_transport = true;
-    vcml::tlm_sbi info = vcml::SBI_NONE;
-    if (tx.is_debug)
-        info |= vcml::SBI_DEBUG;
-    if (tx.is_excl)
-        info |= vcml::SBI_EXCL;
-    if (tx.is_secure)
-        info |= vcml::SBI_SECURE;
-    info.cpuid = core_id();
-    tlm::tlm_response_status resp = tlm::TLM_GENERIC_ERROR_RESPONSE;
-
-    resp = tx.is_read ? data.read(tx.addr, tx.data, tx.size, info)
-                      : data.write(tx.addr, tx.data, tx.size, info);
-    m_transport = false;
+    if (on_worker()) {
+        ocx::response resp = ocx::RESP_FAILED;
+        sc_call([&]() { resp = transport(tx); });
+        return resp;
+    }
+
+    size_t sbi = (tx.is_debug ? 1 : 0) | (tx.is_excl ? 2 : 0) |
+                 (tx.is_secure ? 4 : 0);
+
+    if (!tx.is_debug)
+        m_quantum.activity();
+
+    m_stats.transport_read += tx.is_read ? 1 : 0;
+    m_stats.transport_write += tx.is_read ? 0 : 1;
+    m_stats.transport_debug += tx.is_debug ? 1 : 0;
+    m_stats.transport_excl += tx.is_excl ? 1 : 0;
+    region_stats* region = find_region(tx.addr);
+    if (region) {
+        region->transports++;
+        if (region->posted && !tx.is_read && !tx.is_debug && !tx.is_excl &&
+            tx.size <= POSTED_WRITE_MAX) {
+            region->posted_writes++;
+            post_write(tx, sbi);
+            return ocx::RESP_OK;
+        }
+    }
+
+    // posted writes must reach their devices before any other access, and
+    // if one of them failed, the next guest access takes the error instead
+    flush_posted_writes();
+
+    tlm::tlm_response_status resp = tlm::TLM_OK_RESPONSE;
+    if (!tx.is_debug)
+        std::swap(resp, m_posted_error);
+
+    if (resp == tlm::TLM_OK_RESPONSE) {
+        m_transport = true;
+        const vcml::tlm_sbi& info = m_sbi[sbi];
+        resp = tx.is_read ? data.read(tx.addr, tx.data, tx.size, info)
+                          : data.write(tx.addr, tx.data, tx.size, info);
+        m_transport = false;
+    }
 
     switch (resp) {
     case tlm::TLM_OK_RESPONSE:
@@ -114,6 +355,39 @@ void core::log_timing_info() const {
     log_info("  sleep cycles : %llu (%.1f %%)", m_sleep_cycles,
              static_cast<double>(m_sleep_cycles) * 100.0 /
                  static_cast<double>(cycle_count() + m_sleep_cycles));
+    log_info("  dmi requests : %llu (%llu misses)", m_stats.dmi_requests,
+             m_stats.dmi_misses);
+    log_info("  transports   : %llu read, %llu write",
+             m_stats.transport_read, m_stats.transport_write);
+    log_info("  page updates : %llu (%llu avoided)", m_stats.page_updates,
+             m_page_updates_avoided.load(std::memory_order_relaxed));
+    log_info("  tb cache     : %s, %zu code pages, %llu retranslated, "
+             "%llu flushes",
+             tbsize.get().c_str(), m_code_pages.size(),
+             m_stats.code_pages_retranslated, m_stats.tb_flushes);
+    if (m_syscalls_drained > 0) {
+        log_info("  syscalls     : %llu sent, %llu queued (max depth %zu)",
+                 m_stats.syscalls, m_syscalls_drained, m_syscall_max_depth);
+        log_info("  queue delay  : avg %.1f ns, max %.1f ns",
+                 m_syscall_latency_ps * 1e-3 / m_syscalls_drained,
+                 m_syscall_max_latency_ps * 1e-3);
+    }
+    if (m_num_resets > 0) {
+        log_info("  resets       : %llu (avg %.1f us%s)", m_num_resets,
+                 m_reset_time * 1e6 / m_num_resets,
+                 reset_in_place ? ", in place" : "");
+    }
+    if (m_worker) {
+        log_info("  worker calls : %llu in %llu quanta",
+                 m_worker->num_calls(), m_worker->num_jobs());
+    }
+
+    for (const auto& region : m_regions) {
+        log_info("  region 0x%llx..0x%llx : %llu transports, %llu posted, "
+                 "%llu dmi hits",
+                 region.addr.start, region.addr.end, region.transports,
+                 region.posted_writes, region.dmi_hits);
+    }
 
     for (auto i : irq) {
         vcml::irq_stats stats;
@@ -131,59 +405,129 @@ void core::log_timing_info() const {
 }
 
 void core::signal(ocx::u64 sigid, bool set) {
+    if (on_worker()) {
+        m_deferred.push_back({ deferred_op::SIGNAL, sigid, set });
+        return;
+    }
+
     timer_irq_out[sigid] = set;
 }
 
 void core::broadcast_syscall(int callno, shared_ptr<void> arg, bool async) {
+    // asynchronous syscalls only need to reach the other cores before their
+    // next quantum, queueing them is safe from any thread
+    if (async) {
+        m_stats.syscalls++;
+        handle_syscall(callno, arg);
+        vcml::u64 now = vcml::time_to_ps(local_time_stamp());
+        for (core* peer : m_syscall_peers)
+            peer->queue_syscall(callno, arg, now);
+        return;
+    }
+
+    if (on_worker()) {
+        sc_call([&]() { broadcast_syscall(callno, arg, async); });
+        return;
+    }
+
+    m_stats.syscalls++;
     handle_syscall(callno, arg);
-    for (auto it = m_syscall_subscriber.begin();
-         it != m_syscall_subscriber.end();) {
-        auto cpu_ptr = it->lock();
-        if (!cpu_ptr) {
-            it = m_syscall_subscriber.erase(it);
-            continue;
-        }
-        cpu_ptr->handle_syscall(callno, arg);
-        ++it;
+    for (core* peer : m_syscall_peers)
+        peer->handle_syscall(callno, arg);
+}
+
+void core::queue_syscall(int callno, const shared_ptr<void>& arg,
+                         vcml::u64 time_ps) {
+    std::lock_guard<std::mutex> guard(m_syscall_mtx);
+    m_syscalls.push_back({ callno, arg, time_ps });
+    m_syscall_max_depth = std::max(m_syscall_max_depth, m_syscalls.size());
+    m_has_syscalls = true;
+}
+
+void core::drain_syscalls() {
+    if (!m_has_syscalls)
+        return;
+
+    vector<pending_syscall> syscalls;
+    {
+        std::lock_guard<std::mutex> guard(m_syscall_mtx);
+        syscalls.swap(m_syscalls);
+        m_has_syscalls = false;
     }
+
+    vcml::u64 now = vcml::time_to_ps(local_time_stamp());
+    for (pending_syscall& sc : syscalls) {
+        vcml::u64 latency = now > sc.time_ps ? now - sc.time_ps : 0;
+        m_syscall_latency_ps += latency;
+        m_syscall_max_latency_ps = std::max(m_syscall_max_latency_ps,
+                                            latency);
+        handle_syscall(sc.callno, std::move(sc.arg));
+    }
+
+    m_syscalls_drained += syscalls.size();
 }
 
 ocx::u64 core::get_time_ps() {
-    return vcml::time_to_ps(sc_core::sc_time_stamp());
+    return vcml::time_to_ps(sc_core::sc_time_stamp()) + m_time_offset_ps;
 }
 
 const char* core::get_param(const char* name) {
     if (strcmp("gicv3", name) == 0)
-        return "false";
+        return gicv3 ? "true" : "false";
     if (strcmp("tbsize", name) == 0)
-        return "8MB";
-    VCML_ERROR("Unimplemented parameter requested");
+        return tbsize.get().c_str();
+    VCML_ERROR("Unimplemented parameter '%s' requested", name);
 }
 
 void core::notify(ocx::u64 eventid, ocx::u64 time_ps) {
-    sc_core::sc_time notify_time = time_from_ps(time_ps);
-    sc_core::sc_time delta = notify_time - sc_core::sc_time_stamp();
-    timer_events[eventid].notify(delta);
+    if (on_worker()) {
+        m_deferred.push_back({ deferred_op::NOTIFY, eventid, time_ps });
+        return;
+    }
+
+    time_ps = time_ps > m_time_offset_ps ? time_ps - m_time_offset_ps : 0;
+    m_timers->schedule(m_timer_base + eventid, time_ps);
+    m_stats.timer_notify++;
+    m_quantum.activity();
 }
 
 void core::cancel(ocx::u64 eventid) {
-    timer_events[eventid].cancel();
+    if (on_worker()) {
+        m_deferred.push_back({ deferred_op::CANCEL, eventid, 0 });
+        return;
+    }
+
+    m_stats.timer_cancel++;
+    m_timers->cancel(m_timer_base + eventid);
 }
 
 void core::hint(ocx::hint_kind kind) {
+    if (on_worker()) {
+        sc_call([&]() { hint(kind); });
+        return;
+    }
+
     switch (kind) {
     case ocx::HINT_WFI: {
+        m_stats.wfi++;
+        flush_posted_writes();
         sync();
-        for (auto it : irq) {
-            if (it.second->read())
-                return;
-        }
+        if (irq_pending())
+            return;
+
         const sc_core::sc_time before_wait = sc_core::sc_time_stamp();
+        if (m_idle)
+            m_idle->enter(m_core_id, vcml::time_to_ps(before_wait));
         wait_for_interrupt(m_irqev);
+
+        const sc_core::sc_time now = sc_core::sc_time_stamp();
+        if (m_idle)
+            m_idle->leave(m_core_id, vcml::time_to_ps(now));
+
         VCML_ERROR_ON(local_time() != sc_core::SC_ZERO_TIME,
                       "core not synchronized");
-        const vcml::u64 cycles = (sc_core::sc_time_stamp() - before_wait) /
-                                 clock_cycle();
+        const sc_core::sc_time slept = now - before_wait;
+        const vcml::u64 cycles = slept / clock_cycle();
         m_sleep_cycles += cycles;
         m_core->stop();
         break;
@@ -194,16 +538,34 @@ void core::hint(ocx::hint_kind kind) {
 }
 
 void core::handle_begin_basic_block(ocx::u64 vaddr) {
-    notify_basic_block(vaddr, 0, 0, local_time_stamp());
+    if (m_bb_trace)
+        m_bb_trace->record(vaddr, vcml::time_to_ps(local_time_stamp()));
+    if (m_coverage_on)
+        record_coverage(vaddr);
+    if (m_bb_subscribed) {
+        sc_core::sc_time t = local_time_stamp();
+        sc_call([&]() { notify_basic_block(vaddr, 0, 0, t); });
+    }
 }
 
 bool core::handle_breakpoint(ocx::u64 vaddr) {
+    if (on_worker()) {
+        sc_call([&]() { handle_breakpoint(vaddr); });
+        return true;
+    }
+
     notify_breakpoint_hit(vaddr, local_time_stamp());
     return true;
 }
 
 bool core::handle_watchpoint(ocx::u64 vaddr, ocx::u64 size, ocx::u64 data,
                              bool iswr) {
+    if (on_worker()) {
+        bool ret = false;
+        sc_call([&]() { ret = handle_watchpoint(vaddr, size, data, iswr); });
+        return ret;
+    }
+
     const vcml::range range(vaddr, vaddr + size);
 
     if (iswr)
@@ -218,38 +580,387 @@ void core::add_syscall_subscriber(const weak_ptr<core>& cpu) {
 }
 
 void core::update_page(vcml::u64 page_addr) {
-    m_core->tb_flush_page(page_addr, page_addr + page_size() - 1);
+    update_page_range(page_addr, page_addr, page_addr + page_size() - 1);
+}
+
+void core::update_page_range(vcml::u64 page_addr, vcml::u64 start,
+                             vcml::u64 end) {
+    invalidate_code_page(page_addr, start, end);
+}
+
+void core::page_written(mem_protector_if* const* owners, size_t n) {
+    // cores of the cluster that were spared, since they hold no
+    // translations from the written page
+    for (core* peer : m_syscall_peers) {
+        if (std::find(owners, owners + n, peer) == owners + n)
+            m_page_updates_avoided.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void core::invalidate_code_page(vcml::u64 page_addr, vcml::u64 start,
+                                vcml::u64 end) {
+    // the ocx core must only be accessed from the thread executing it, so
+    // writes from other threads are handled at the start of the next quantum
+    if (m_thread != std::this_thread::get_id()) {
+        std::lock_guard<spin_lock> guard(m_page_update_lock);
+        if (m_num_page_updates < m_page_updates.size())
+            m_page_updates[m_num_page_updates++] = { page_addr, start, end };
+        else
+            m_page_update_overflow = true;
+        m_has_page_updates = true;
+        return;
+    }
+
+    // the page pointer must be dropped as a whole, so that the next
+    // translation re-protects the written host page
+    m_core->tb_flush_page(start, end);
     m_core->invalidate_page_ptr(page_addr);
-    for (auto it = m_syscall_subscriber.begin();
-         it != m_syscall_subscriber.end();) {
-        auto cpu_ptr = it->lock();
+    if (m_num_written_pages < m_written_pages.size())
+        m_written_pages[m_num_written_pages++] = page_addr;
+    else
+        m_written_pages_overflow = true;
+    m_stats.page_updates++;
+}
 
-        if (!cpu_ptr) {
-            it = m_syscall_subscriber.erase(it);
-            continue;
-        }
+void core::drain_written_pages() {
+    // forgetting all pages only miscounts later translations as new ones
+    if (m_written_pages_overflow) {
+        m_code_pages.clear();
+    } else {
+        for (size_t i = 0; i < m_num_written_pages; ++i)
+            m_code_pages.erase(m_written_pages[i]);
+    }
+
+    m_num_written_pages = 0;
+    m_written_pages_overflow = false;
+}
+
+void core::drain_dmi_flushes() {
+    if (!m_has_dmi_flushes)
+        return;
 
-        cpu_ptr->m_core->tb_flush_page(page_addr, page_addr + page_size() - 1);
-        cpu_ptr->m_core->invalidate_page_ptr(page_addr);
-        ++it;
+    vector<vcml::range> ranges;
+    {
+        std::lock_guard<std::mutex> guard(m_dmi_flush_mtx);
+        ranges.swap(m_dmi_flushes);
+        m_has_dmi_flushes = false;
+    }
+
+    for (const vcml::range& r : ranges) {
+        flush_dmi_mru(r.start, r.end);
+        flush_no_dmi(r.start, r.end);
+        m_inv_range->invalidate_page_ptrs(r.start, r.end);
     }
 }
 
+void core::drain_page_updates() {
+    if (!m_has_page_updates)
+        return;
+
+    array<page_update, PAGE_UPDATE_SLOTS> pages;
+    size_t npages = 0;
+    bool overflow = false;
+    {
+        std::lock_guard<spin_lock> guard(m_page_update_lock);
+        npages = m_num_page_updates;
+        overflow = m_page_update_overflow;
+        std::copy_n(m_page_updates.begin(), npages, pages.begin());
+        m_num_page_updates = 0;
+        m_page_update_overflow = false;
+        m_has_page_updates = false;
+    }
+
+    if (overflow) {
+        // dropping all page pointers makes the next translations re-protect
+        // their pages
+        m_core->tb_flush();
+        m_inv_range->invalidate_page_ptrs(0, ~0ull);
+        m_code_pages.clear();
+        m_num_written_pages = 0;
+        m_stats.tb_flushes++;
+        return;
+    }
+
+    for (size_t i = 0; i < npages; ++i) {
+        m_core->tb_flush_page(pages[i].start, pages[i].end);
+        m_core->invalidate_page_ptr(pages[i].page_addr);
+        m_code_pages.erase(pages[i].page_addr);
+    }
+
+    m_stats.page_updates += npages;
+}
+
 void core::timer_irq_trigger(int timer_id) {
-    m_core->notified(timer_id);
+    run_or_queue({ deferred_op::TIMER, static_cast<vcml::u64>(timer_id), 0 });
+}
+
+void core::save_state(snapshot_section& sec) {
+    sec.put<vcml::u64>(get_time_ps());
+
+    // includes the system registers known to the OCX core
+    vcml::u64 nregs = m_core->num_regs();
+    sec.put(nregs);
+    for (vcml::u64 reg = 0; reg < nregs; ++reg) {
+        vector<vcml::u8> buf(m_core->reg_size(reg));
+        vcml::u64 size = buf.size();
+        if (!m_core->read_reg(reg, buf.data()))
+            size = 0;
+        sec.put(size);
+        sec.write(buf.data(), size);
+    }
+
+    for (size_t i = 0; i < ARM_TIMER_COUNT; ++i) {
+        vcml::u64 deadline = m_timers->deadline(m_timer_base + i);
+        if (deadline != timer_wheel::NONE)
+            deadline += m_time_offset_ps;
+        sec.put(deadline);
+        sec.put<vcml::u8>(timer_irq_out[i].read());
+    }
+}
+
+void core::restore_state(snapshot_section& sec) {
+    vcml::u64 now = vcml::time_to_ps(sc_core::sc_time_stamp());
+    vcml::u64 guest = sec.get<vcml::u64>();
+    m_time_offset_ps = guest > now ? guest - now : 0;
+
+    vcml::u64 nregs = sec.get<vcml::u64>();
+    VCML_ERROR_ON(nregs != m_core->num_regs(),
+                  "snapshot holds %llu registers, core has %llu", nregs,
+                  static_cast<vcml::u64>(m_core->num_regs()));
+
+    // read-only registers, e.g. ID registers, refuse the write
+    size_t readonly = 0;
+    vector<vcml::u8> buf;
+    for (vcml::u64 reg = 0; reg < nregs; ++reg) {
+        buf.resize(sec.get<vcml::u64>());
+        sec.read(buf.data(), buf.size());
+        if (!buf.empty() && !m_core->write_reg(reg, buf.data()))
+            readonly++;
+    }
+
+    if (readonly > 0)
+        log_debug("%zu registers not restored", readonly);
+
+    for (size_t i = 0; i < ARM_TIMER_COUNT; ++i) {
+        vcml::u64 deadline = sec.get<vcml::u64>();
+        if (deadline == timer_wheel::NONE)
+            m_timers->cancel(m_timer_base + i);
+        else
+            notify(i, deadline);
+        timer_irq_out[i] = sec.get<vcml::u8>() != 0;
+    }
+
+    // translations of the previous guest state are stale
+    m_core->tb_flush();
+    m_code_pages.clear();
+    m_num_written_pages = 0;
+    m_stats.tb_flushes++;
+    flush_no_dmi(0, ~0ull);
+}
+
+void core::before_quantum(const std::function<void()>& func) {
+    m_before_quantum.push_back(func);
+}
+
+void core::before_fork() {
+    // only the forking thread exists in the child
+    m_worker.reset();
+    if (m_bb_trace)
+        m_bb_trace->suspend();
+}
+
+void core::after_fork(size_t child_id) {
+    // children share the host, so their workers are not pinned
+    if (parallel)
+        m_worker = std::make_unique<worker>(child_id ? -1 : worker_cpu());
+
+    if (child_id == 0) {
+        if (m_bb_trace)
+            m_bb_trace->resume();
+        return;
+    }
+
+    m_fork_id = child_id;
+    if (m_bb_trace) {
+        m_bb_trace->discard();
+        start_binary_trace(mwr::mkstr(
+            "%s.%s.bin", output_file(bbtrace_file).c_str(), name()));
+    }
+}
+
+string core::output_file(const string& base) const {
+    return m_fork_id ? mwr::mkstr("%s.%zu", base.c_str(), m_fork_id) : base;
+}
+
+int core::worker_cpu() const {
+    if (!parallel_pin)
+        return -1;
+
+    unsigned int ncpus = std::max(std::thread::hardware_concurrency(), 1u);
+    return static_cast<int>(m_core_id % ncpus);
+}
+
+void core::use_timers(timer_dispatcher& timers) {
+    VCML_ERROR_ON(m_timers, "timers already assigned");
+    m_timers = &timers;
+    m_timer_base = timers.add_client(ARM_TIMER_COUNT, [this](size_t id) {
+        timer_irq_trigger(static_cast<int>(id));
+    });
+}
+
+bool core::irq_pending() {
+    for (auto it : irq) {
+        if (it.second->read())
+            return true;
+    }
+
+    return false;
 }
 
 void core::interrupt(size_t irq, bool set) {
-    m_core->interrupt(irq, set);
+    run_or_queue({ deferred_op::INTERRUPT, irq, set });
     m_irqev.notify();
+    m_quantum.activity();
 }
 
 void core::simulate(size_t cycles) {
+    if (!m_before_quantum.empty()) {
+        auto funcs = std::move(m_before_quantum);
+        m_before_quantum.clear();
+        for (const auto& func : funcs)
+            func();
+    }
+
     // insn_count() is only reset at the beginning of step(), but not at
     // the end, so the number of cycles can only be summed up in the
     // following quantum
     m_run_cycles += m_core->insn_count();
+    m_stats.quanta++;
+    m_stats.page_updates_avoided = m_page_updates_avoided.load(
+        std::memory_order_relaxed);
+
+    // guest mappings may have changed since the previous quantum
+    if (m_coverage_on)
+        std::fill(m_coverage_seen.begin(), m_coverage_seen.end(), ~0ull);
+
+    // the adaptive quantum replaces the global one, but single steps
+    // requested by debuggers are kept
+    if (quantum_max.get() > sc_core::SC_ZERO_TIME && !m_quantum.enabled()) {
+        sc_core::sc_time cycle = clock_cycle();
+        m_quantum.configure(static_cast<vcml::u64>(quantum_min / cycle),
+                            static_cast<vcml::u64>(quantum_max / cycle));
+    }
+    if (m_quantum.enabled() && cycles > 1)
+        cycles = m_quantum.quantum();
+
+    if (m_worker) {
+        m_worker->start([this, cycles]() { run_quantum(cycles); });
+
+        // give the other cores the chance to start their quanta before
+        // serving this one; deterministic mode skips this, so its cores
+        // run one after the other exactly like in sequential mode
+        if (!parallel_deterministic)
+            sc_core::wait(sc_core::SC_ZERO_TIME);
+
+        m_worker->finish();
+        apply_deferred();
+    } else {
+        run_quantum(cycles);
+    }
+
+    flush_posted_writes();
+
+    if (m_quantum.enabled())
+        m_quantum.update(m_core->insn_count());
+
+    if (m_profiler)
+        sample_profile(m_core->insn_count());
+}
+
+void core::run_quantum(size_t cycles) {
+    // with async or parallel enabled, quanta run on other host threads
+    m_thread = std::this_thread::get_id();
+    drain_page_updates();
+    drain_written_pages();
+    drain_dmi_flushes();
+    drain_syscalls();
+
+    set_core_busy(true);
     m_core->step(cycles);
+    set_core_busy(false);
+}
+
+void core::sc_call(const worker::function& func) {
+    if (!on_worker()) {
+        func();
+        return;
+    }
+
+    // deferred timer updates must precede what the core does next; the
+    // core is idle while the worker waits for the call to return
+    m_worker->call([&]() {
+        set_core_busy(false);
+        apply_deferred();
+        func();
+        set_core_busy(true);
+    });
+}
+
+void core::apply_deferred() {
+    for (const deferred_op& op : m_deferred) {
+        switch (op.op) {
+        case deferred_op::NOTIFY:
+            notify(op.id, op.arg);
+            break;
+        case deferred_op::CANCEL:
+            cancel(op.id);
+            break;
+        case deferred_op::SIGNAL:
+            signal(op.id, op.arg != 0);
+            break;
+        default:
+            VCML_ERROR("unknown deferred operation");
+        }
+    }
+
+    m_deferred.clear();
+}
+
+void core::apply_inbound(const deferred_op& op) {
+    switch (op.op) {
+    case deferred_op::INTERRUPT:
+        m_core->interrupt(op.id, op.arg != 0);
+        break;
+    case deferred_op::TIMER:
+        m_core->notified(op.id);
+        break;
+    default:
+        VCML_ERROR("unknown inbound operation");
+    }
+}
+
+void core::run_or_queue(const deferred_op& op) {
+    if (!m_worker || on_worker()) {
+        apply_inbound(op);
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(m_inbound_mtx);
+    if (m_core_busy)
+        m_inbound.push_back(op);
+    else
+        apply_inbound(op);
+}
+
+void core::set_core_busy(bool busy) {
+    if (!m_worker)
+        return;
+
+    std::lock_guard<std::mutex> guard(m_inbound_mtx);
+    for (const deferred_op& op : m_inbound)
+        apply_inbound(op);
+    m_inbound.clear();
+    m_core_busy = busy;
 }
 
 bool core::read_reg_dbg(size_t regno, void* buf, size_t len) {
@@ -322,15 +1033,61 @@ bool core::remove_watchpoint(const vcml::range& mem, vcml::vcml_access acs) {
 }
 
 bool core::start_basic_block_trace() {
-    m_core->trace_basic_blocks(true);
+    m_bb_subscribed = true;
+    update_bb_trace();
     return true;
 }
 
 bool core::stop_basic_block_trace() {
-    m_core->trace_basic_blocks(false);
+    m_bb_subscribed = false;
+    update_bb_trace();
     return true;
 }
 
+void core::update_bb_trace() {
+    m_core->trace_basic_blocks(m_bb_subscribed || m_bb_trace ||
+                                 m_coverage_on);
+}
+
+void core::record_coverage(vcml::u64 vaddr) {
+    vcml::u64& seen = m_coverage_seen[(vaddr >> 2) % COVERAGE_SEEN_SIZE];
+    if (seen == vaddr)
+        return;
+
+    seen = vaddr;
+    vcml::u64 paddr;
+    if (virt_to_phys(vaddr, paddr))
+        m_coverage.set(paddr);
+}
+
+void core::start_coverage() {
+    m_coverage_on = true;
+    m_coverage_seen.assign(COVERAGE_SEEN_SIZE, ~0ull);
+    update_bb_trace();
+}
+
+void core::stop_coverage() {
+    // collected coverage is kept, restarting adds to it
+    m_coverage_on = false;
+    update_bb_trace();
+}
+
+void core::start_binary_trace(const string& path) {
+    stop_binary_trace();
+    m_bb_trace = std::make_unique<bb_trace_writer>(path, m_core_id);
+    update_bb_trace();
+}
+
+void core::stop_binary_trace() {
+    if (!m_bb_trace)
+        return;
+
+    m_bb_trace->close();
+    log_debug("wrote %llu basic blocks to trace", m_bb_trace->num_records());
+    m_bb_trace.reset();
+    update_bb_trace();
+}
+
 vcml::u64 core::cycle_count() const {
     return m_run_cycles + m_core->insn_count();
 }
@@ -377,19 +1134,114 @@ vcml::u64 core::page_size() {
     return m_core->page_size();
 }
 
+bool core::read_guest_u64(vcml::u64 vaddr, vcml::u64& val) {
+    vcml::u64 paddr = 0;
+    if (!virt_to_phys(vaddr, paddr))
+        return false;
+
+    return data.read(paddr, &val, sizeof(val), vcml::SBI_DEBUG) ==
+           tlm::TLM_OK_RESPONSE;
+}
+
+void core::sample_profile(vcml::u64 insns) {
+    // samples can only be taken at quantum boundaries, each one is weighted
+    // with the instructions executed since the previous sample
+    m_profile_insns += insns;
+    if (m_profile_insns < profile_interval)
+        return;
+
+    array<vcml::u64, profiler::MAX_DEPTH> frames;
+    size_t depth = 0;
+    frames[depth++] = program_counter();
+
+    // walk the aarch64 frame records: [fp] = caller fp, [fp + 8] = lr
+    vcml::u64 fp = 0;
+    size_t max_depth = std::min<size_t>(profile_depth + 1, frames.size());
+    if (depth < max_depth && m_core->read_reg(29, &fp)) {
+        while (depth < max_depth && fp != 0 && (fp & 0xf) == 0) {
+            vcml::u64 next_fp = 0, lr = 0;
+            if (!read_guest_u64(fp, next_fp) || !read_guest_u64(fp + 8, lr))
+                break;
+
+            if (lr == 0)
+                break;
+
+            frames[depth++] = lr;
+
+            // the stack grows downwards, anything else is a corrupt chain
+            if (next_fp <= fp)
+                break;
+
+            fp = next_fp;
+        }
+    }
+
+    m_profiler->sample(m_profile_insns, frames.data(), depth);
+    m_profile_insns = 0;
+}
+
+string core::symbolize(vcml::u64 addr) {
+    const auto* func = vcml::debugging::target::symbols().find_function(addr);
+    if (func)
+        return func->name();
+    return mwr::mkstr("0x%016llx", addr);
+}
+
+void core::write_profile() {
+    auto sym = [this](vcml::u64 addr) { return symbolize(addr); };
+
+    const string base = output_file(profile_output);
+    string flat = mwr::mkstr("%s.%s.txt", base.c_str(), name());
+    std::ofstream flat_os(flat);
+    if (!flat_os.good()) {
+        log_warn("cannot write profile '%s'", flat.c_str());
+        return;
+    }
+
+    m_profiler->write_flat(flat_os, sym);
+
+    string folded = mwr::mkstr("%s.%s.folded", base.c_str(), name());
+    std::ofstream folded_os(folded);
+    if (!folded_os.good()) {
+        log_warn("cannot write profile '%s'", folded.c_str());
+        return;
+    }
+
+    m_profiler->write_folded(folded_os, sym);
+    log_info("wrote %llu profile samples to %s", m_profiler->num_samples(),
+             flat.c_str());
+}
+
+void core::end_of_simulation() {
+    vcml::processor::end_of_simulation();
+    if (m_profiler)
+        write_profile();
+    stop_binary_trace();
+}
+
 void core::end_of_elaboration() {
-    for (size_t i = 0; i < timer_events.size(); ++i) {
-        sc_core::sc_spawn_options opts;
-        opts.spawn_method();
-        opts.set_sensitivity(&timer_events[i]);
-        opts.dont_initialize();
-
-        std::stringstream ss;
-        ss << timer_events[i].basename() << "_trigger";
-        sc_core::sc_spawn(sc_bind(&core::timer_irq_trigger, this, i),
-                          sc_core::sc_gen_unique_name(ss.str().c_str()),
-                          &opts);
+    if (!bbtrace_file.get().empty()) {
+        start_binary_trace(
+            mwr::mkstr("%s.%s.bin", bbtrace_file.get().c_str(), name()));
     }
+
+    // the cluster merges and writes the coverage of all its cores
+    if (!coverage_file.get().empty())
+        start_coverage();
+
+    // all cores of a cluster live as long as the cluster itself
+    m_syscall_peers.clear();
+    for (const auto& subscriber : m_syscall_subscriber) {
+        if (auto peer = subscriber.lock())
+            m_syscall_peers.push_back(peer.get());
+    }
+
+    if (!m_timers) {
+        m_own_timers = std::make_unique<timer_dispatcher>();
+        use_timers(*m_own_timers);
+        m_own_timers->start("arm_timer_trigger");
+    }
+
     vcml::processor::end_of_elaboration();
 }
 
@@ -413,37 +1265,139 @@ core::core(const sc_core::sc_module_name& nm, vcml::u64 procid,
            vcml::u64 coreid):
     vcml::processor(nm, CPU_ARCH),
     m_core(nullptr),
+    m_inv_range(nullptr),
     m_irqev("irqev"),
     m_core_id(coreid),
     m_proc_id(procid),
     m_run_cycles(0),
     m_sleep_cycles(0),
+    m_idle(nullptr),
+    m_timers(nullptr),
+    m_own_timers(),
+    m_timer_base(0),
+    m_time_offset_ps(0),
+    m_before_quantum(),
+    m_fork_id(0),
     m_transport(false),
-    m_ocx_handle(nullptr),
-    m_create_instance(nullptr),
-    m_delete_instance(nullptr),
+    m_ocx(ocx_library::get()),
+    m_num_resets(0),
+    m_reset_time(0.0),
     m_syscall_subscriber(),
+    m_syscall_peers(),
+    m_syscall_mtx(),
     m_syscalls(),
-    timer_irq_out("TIMER_IRQ_OUT"),
-    timer_events{ { sc_core::sc_event("arm_timer_ns"),
-                    sc_core::sc_event("arm_timer_virt"),
-                    sc_core::sc_event("arm_timer_hyp"),
-                    sc_core::sc_event("arm_timer_s") } } {
+    m_has_syscalls(false),
+    m_syscall_max_depth(0),
+    m_syscalls_drained(0),
+    m_syscall_latency_ps(0),
+    m_syscall_max_latency_ps(0),
+    m_thread(std::this_thread::get_id()),
+    m_page_update_lock(),
+    m_page_updates(),
+    m_num_page_updates(0),
+    m_page_update_overflow(false),
+    m_has_page_updates(false),
+    m_page_updates_avoided(0),
+    m_dmi_flush_mtx(),
+    m_dmi_flushes(),
+    m_has_dmi_flushes(false),
+    m_dmi_mru(),
+    m_no_dmi(),
+    m_no_dmi_idx(),
+    m_sbi(),
+    m_regions(),
+    m_region_index(),
+    m_stats(),
+    m_code_pages(),
+    m_written_pages(),
+    m_num_written_pages(0),
+    m_written_pages_overflow(false),
+    m_posted(),
+    m_num_posted(0),
+    m_posted_error(tlm::TLM_OK_RESPONSE),
+    m_profiler(),
+    m_profile_insns(0),
+    m_bb_subscribed(false),
+    m_bb_trace(),
+    m_coverage_on(false),
+    m_coverage(),
+    m_coverage_seen(),
+    m_quantum(),
+    m_worker(),
+    m_deferred(),
+    m_inbound_mtx(),
+    m_inbound(),
+    m_core_busy(false),
+    hugepages("hugepages", false),
+    posted_writes("posted_writes"),
+    profile("profile", false),
+    profile_interval("profile_interval", 100000),
+    profile_depth("profile_depth", 0),
+    profile_buffer("profile_buffer", 1 << 20),
+    profile_output("profile_output", "profile"),
+    bbtrace_file("bbtrace_file", ""),
+    coverage_file("coverage_file", ""),
+    quantum_min("quantum_min", sc_core::SC_ZERO_TIME),
+    quantum_max("quantum_max", sc_core::SC_ZERO_TIME),
+    parallel("parallel", false),
+    parallel_deterministic("parallel_deterministic", false),
+    parallel_pin("parallel_pin", true),
+    reset_in_place("reset_in_place", false),
+    tbsize("tbsize", "8MB"),
+    gicv3("gicv3", false),
+    timer_irq_out("TIMER_IRQ_OUT") {
     symbols.inherit_default();
     async.inherit_default();
     async_rate.inherit_default();
+    hugepages.inherit_default();
+    posted_writes.inherit_default();
+    profile.inherit_default();
+    profile_interval.inherit_default();
+    profile_depth.inherit_default();
+    profile_buffer.inherit_default();
+    profile_output.inherit_default();
+    bbtrace_file.inherit_default();
+    coverage_file.inherit_default();
+    quantum_min.inherit_default();
+    quantum_max.inherit_default();
+    parallel.inherit_default();
+    parallel_deterministic.inherit_default();
+    parallel_pin.inherit_default();
+    reset_in_place.inherit_default();
+    tbsize.inherit_default();
+    gicv3.inherit_default();
+    flush_dmi_mru(0, ~0ull);
+    flush_no_dmi(0, ~0ull);
+
+    for (size_t i = 0; i < 8; ++i) {
+        vcml::tlm_sbi info = vcml::SBI_NONE;
+        if (i & 1)
+            info |= vcml::SBI_DEBUG;
+        if (i & 2)
+            info |= vcml::SBI_EXCL;
+        if (i & 4)
+            info |= vcml::SBI_SECURE;
+        info.cpuid = coreid;
+        m_sbi.push_back(info);
+    }
 
-    if (symbols.is_default() && !symbols.get().empty())
-        load_symbols();
+    for (const vcml::range& addr : posted_writes) {
+        VCML_ERROR_ON(find_region(addr.start) || find_region(addr.end),
+                      "posted range 0x%llx..0x%llx overlaps another one",
+                      addr.start, addr.end);
+        insert_region({ addr, true, 0, 0, 0 });
+    }
 
-    m_ocx_handle = dlopen("libocx-qemu-arm.so", RTLD_LAZY);
-    VCML_ERROR_ON(!m_ocx_handle, "Could not load libocx-qemu-arm.so: %s",
-                  dlerror());
+    if (parallel) {
+        VCML_ERROR_ON(async, "parallel and async cannot be used together");
+        m_worker = std::make_unique<worker>(worker_cpu());
+    }
 
-    m_create_instance = get_ocx_function_ptr<create_instance_t>(
-        "_ZN3ocx15create_instanceEmRNS_3envEPKc");
-    m_delete_instance = get_ocx_function_ptr<delete_instance_t>(
-        "_ZN3ocx15delete_instanceEPNS_4coreE");
+    if (profile)
+        m_profiler = std::make_unique<profiler>(profile_buffer);
+
+    if (symbols.is_default() && !symbols.get().empty())
+        load_symbols();
 
     open_core();
 
@@ -489,8 +1443,58 @@ void core::reset() {
     m_sleep_cycles = 0;
     m_transport = false;
 
-    close_core();
-    open_core();
+    // a restored guest clock does not survive the reset
+    m_time_offset_ps = 0;
+
+    // resetting in place keeps the QEMU CPU state and translation cache
+    // allocated, only the translations themselves are dropped
+    double t = mwr::timestamp();
+    if (reset_in_place) {
+        m_core->reset();
+        m_core->tb_flush();
+    } else {
+        close_core();
+        open_core();
+    }
+
+    m_reset_time += mwr::timestamp() - t;
+    m_num_resets++;
+    m_code_pages.clear();
+    m_num_written_pages = 0;
+    m_written_pages_overflow = false;
+    update_bb_trace();
+
+    {
+        std::lock_guard<spin_lock> guard(m_page_update_lock);
+        m_num_page_updates = 0;
+        m_page_update_overflow = false;
+        m_has_page_updates = false;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_dmi_flush_mtx);
+        m_dmi_flushes.clear();
+        m_has_dmi_flushes = false;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_syscall_mtx);
+        m_syscalls.clear();
+        m_has_syscalls = false;
+    }
+
+    m_deferred.clear();
+
+    {
+        std::lock_guard<std::mutex> guard(m_inbound_mtx);
+        m_inbound.clear();
+    }
+
+    // devices may grant DMI differently after reset
+    flush_dmi_mru(0, ~0ull);
+    flush_no_dmi(0, ~0ull);
+    m_num_posted = 0;
+    m_posted_error = tlm::TLM_OK_RESPONSE;
 
     reset_cpuregs();
     flush_cpuregs();
@@ -498,46 +1502,36 @@ void core::reset() {
     // reset all timers
     for (size_t i = 0; i < ARM_TIMER_COUNT; ++i) {
         timer_irq_out[i].lower();
-        timer_events[i].cancel();
+        if (m_timers)
+            m_timers->cancel(m_timer_base + i);
     }
 }
 
 void core::open_core() {
     VCML_ERROR_ON(m_core, "core already initialized");
-    VCML_ERROR_ON(!m_ocx_handle, "OCX handle is not initialized");
-    VCML_ERROR_ON(!m_create_instance,
-                  "OCX create_instance function not found");
+    VCML_ERROR_ON(!m_ocx, "OCX library is not loaded");
 
-    m_core = m_create_instance(20201012ull, *this, CPU_VARIANT);
+    m_core = m_ocx->create_instance(20201012ull, *this, CPU_VARIANT);
     VCML_ERROR_ON(!m_core, "Could not create ocx::core instance");
 
     m_core->set_id(m_proc_id, m_core_id);
+
+    m_inv_range = dynamic_cast<ocx::core_inv_range_extension*>(m_core);
+    VCML_ERROR_ON(!m_inv_range, "OCX core cannot invalidate page ranges");
 }
 
 void core::close_core() {
     if (m_core) {
-        m_delete_instance(m_core);
+        m_ocx->delete_instance(m_core);
         m_core = nullptr;
+        m_inv_range = nullptr;
     }
 }
 
 core::~core() {
+    m_worker.reset();
     close_core();
-
-    m_create_instance = nullptr;
-    m_delete_instance = nullptr;
-    dlclose(m_ocx_handle);
-    m_ocx_handle = nullptr;
-}
-
-template <typename T>
-T core::get_ocx_function_ptr(const char* name) {
-    VCML_ERROR_ON(!m_ocx_handle, "OCX handle is not initialized");
-
-    T func = (T)dlsym(m_ocx_handle, name);
-    const char* dlsym_err = dlerror();
-    VCML_ERROR_ON(dlsym_err, "Could not load symbol %s: %s", name, dlsym_err);
-    return func;
+    m_ocx.reset();
 }
 
 } // namespace psp
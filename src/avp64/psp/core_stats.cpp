@@ -0,0 +1,91 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/core_stats.h"
+
+namespace avp64 {
+namespace psp {
+
+const array<core_stats::field, 16> core_stats::FIELDS = { {
+    { "quanta", &core_stats::quanta },
+    { "transport_read", &core_stats::transport_read },
+    { "transport_write", &core_stats::transport_write },
+    { "transport_debug", &core_stats::transport_debug },
+    { "transport_excl", &core_stats::transport_excl },
+    { "dmi_requests", &core_stats::dmi_requests },
+    { "dmi_misses", &core_stats::dmi_misses },
+    { "page_updates", &core_stats::page_updates },
+    { "page_updates_avoided", &core_stats::page_updates_avoided },
+    { "wfi", &core_stats::wfi },
+    { "timer_notify", &core_stats::timer_notify },
+    { "timer_cancel", &core_stats::timer_cancel },
+    { "syscalls", &core_stats::syscalls },
+    { "tb_flushes", &core_stats::tb_flushes },
+    { "code_pages", &core_stats::code_pages },
+    { "code_pages_retranslated", &core_stats::code_pages_retranslated },
+} };
+
+core_stats::core_stats() {
+    reset();
+}
+
+void core_stats::reset() {
+    for (const auto& f : FIELDS)
+        this->*f.value = 0;
+}
+
+core_stats& core_stats::operator+=(const core_stats& other) {
+    for (const auto& f : FIELDS)
+        this->*f.value += other.*f.value;
+    return *this;
+}
+
+core_stats core_stats::operator-(const core_stats& other) const {
+    core_stats result(*this);
+    for (const auto& f : FIELDS)
+        result.*f.value -= other.*f.value;
+    return result;
+}
+
+string core_stats::csv_header() {
+    string s;
+    for (const auto& f : FIELDS) {
+        if (!s.empty())
+            s += ",";
+        s += f.name;
+    }
+
+    return s;
+}
+
+string core_stats::to_csv() const {
+    string s;
+    for (const auto& f : FIELDS) {
+        if (!s.empty())
+            s += ",";
+        s += std::to_string(this->*f.value);
+    }
+
+    return s;
+}
+
+string core_stats::to_json() const {
+    string s = "{";
+    for (const auto& f : FIELDS) {
+        if (s.size() > 1)
+            s += ",";
+        s += mwr::mkstr("\"%s\":%llu", f.name,
+                        static_cast<unsigned long long>(this->*f.value));
+    }
+
+    return s + "}";
+}
+
+} // namespace psp
+} // namespace avp64
@@ -0,0 +1,153 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/coverage.h"
+
+#include <algorithm>
+#include <bitset>
+#include <fstream>
+
+namespace avp64 {
+namespace psp {
+
+static size_t slot_of(vcml::u64 addr) {
+    return (addr & (coverage_map::PAGE_SIZE - 1)) >> coverage_map::SLOT_BITS;
+}
+
+coverage_map::coverage_map():
+    m_pages(), m_last_page(~0ull), m_last_bits(nullptr) {
+}
+
+coverage_map::coverage_map(const coverage_map& other):
+    m_pages(other.m_pages), m_last_page(~0ull), m_last_bits(nullptr) {
+}
+
+coverage_map& coverage_map::operator=(const coverage_map& other) {
+    m_pages = other.m_pages;
+    m_last_page = ~0ull;
+    m_last_bits = nullptr;
+    return *this;
+}
+
+coverage_map::bitmap& coverage_map::lookup(vcml::u64 page) {
+    if (page != m_last_page) {
+        auto it = m_pages.try_emplace(page).first;
+        m_last_page = page;
+        m_last_bits = &it->second;
+    }
+
+    return *m_last_bits;
+}
+
+void coverage_map::set(vcml::u64 addr) {
+    size_t slot = slot_of(addr);
+    lookup(addr >> PAGE_BITS)[slot / 64] |= 1ull << (slot % 64);
+}
+
+bool coverage_map::test(vcml::u64 addr) const {
+    auto it = m_pages.find(addr >> PAGE_BITS);
+    if (it == m_pages.end())
+        return false;
+
+    size_t slot = slot_of(addr);
+    return (it->second[slot / 64] >> (slot % 64)) & 1;
+}
+
+size_t coverage_map::count() const {
+    size_t n = 0;
+    for (const auto& [page, bits] : m_pages) {
+        for (vcml::u64 word : bits)
+            n += std::bitset<64>(word).count();
+    }
+
+    return n;
+}
+
+void coverage_map::clear() {
+    m_pages.clear();
+    m_last_page = ~0ull;
+    m_last_bits = nullptr;
+}
+
+void coverage_map::merge(const coverage_map& other) {
+    for (const auto& [page, bits] : other.m_pages) {
+        bitmap& dest = lookup(page);
+        for (size_t i = 0; i < WORDS; ++i)
+            dest[i] |= bits[i];
+    }
+}
+
+vector<vcml::u64> coverage_map::sorted_pages() const {
+    vector<vcml::u64> pages;
+    pages.reserve(m_pages.size());
+    for (const auto& entry : m_pages)
+        pages.push_back(entry.first);
+
+    std::sort(pages.begin(), pages.end());
+    return pages;
+}
+
+void coverage_map::for_each(const std::function<void(vcml::u64)>& func) const {
+    for (vcml::u64 page : sorted_pages()) {
+        const bitmap& bits = m_pages.at(page);
+        for (size_t i = 0; i < WORDS; ++i) {
+            for (vcml::u64 word = bits[i]; word; word &= word - 1) {
+                size_t slot = i * 64 + __builtin_ctzll(word);
+                func((page << PAGE_BITS) | (slot << SLOT_BITS));
+            }
+        }
+    }
+}
+
+void coverage_map::save(const string& path) const {
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    VCML_ERROR_ON(!os, "cannot open coverage file '%s'", path.c_str());
+
+    coverage_header header{};
+    std::copy(COVERAGE_MAGIC, COVERAGE_MAGIC + 8, header.magic);
+    header.version = COVERAGE_VERSION;
+    header.num_pages = m_pages.size();
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (vcml::u64 page : sorted_pages()) {
+        const bitmap& bits = m_pages.at(page);
+        os.write(reinterpret_cast<const char*>(&page), sizeof(page));
+        os.write(reinterpret_cast<const char*>(bits.data()), sizeof(bits));
+    }
+
+    VCML_ERROR_ON(!os, "error writing coverage file '%s'", path.c_str());
+}
+
+void coverage_map::load(const string& path) {
+    std::ifstream is(path, std::ios::binary);
+    VCML_ERROR_ON(!is, "cannot open coverage file '%s'", path.c_str());
+
+    coverage_header header{};
+    is.read(reinterpret_cast<char*>(&header), sizeof(header));
+    VCML_ERROR_ON(!is || !std::equal(header.magic, header.magic + 8,
+                                     COVERAGE_MAGIC),
+                  "'%s' is not a coverage file", path.c_str());
+    VCML_ERROR_ON(header.version != COVERAGE_VERSION,
+                  "unsupported coverage file version %u", header.version);
+
+    for (vcml::u64 i = 0; i < header.num_pages; ++i) {
+        vcml::u64 page;
+        bitmap bits;
+        is.read(reinterpret_cast<char*>(&page), sizeof(page));
+        is.read(reinterpret_cast<char*>(bits.data()), sizeof(bits));
+        VCML_ERROR_ON(!is, "coverage file '%s' is truncated", path.c_str());
+
+        bitmap& dest = lookup(page);
+        for (size_t w = 0; w < WORDS; ++w)
+            dest[w] |= bits[w];
+    }
+}
+
+} // namespace psp
+} // namespace avp64
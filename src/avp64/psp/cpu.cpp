@@ -10,6 +10,15 @@
 #include "avp64/psp/cpu.h"
 #include "avp64/version.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sys/wait.h>
+#include <unistd.h>
+
 namespace avp64 {
 namespace psp {
 
@@ -20,6 +29,34 @@ cpu::cpu(const sc_core::sc_module_name& nm):
     symbols("symbols"),
     async("async", false),
     async_rate("async_rate", 10),
+    write_tracking("write_tracking", "signal"),
+    hugepages("hugepages", false),
+    posted_writes("posted_writes"),
+    profile("profile", false),
+    profile_interval("profile_interval", 100000),
+    profile_depth("profile_depth", 0),
+    profile_buffer("profile_buffer", 1 << 20),
+    profile_output("profile_output", "profile"),
+    bbtrace_file("bbtrace_file", ""),
+    coverage_file("coverage_file", ""),
+    quantum_min("quantum_min", sc_core::SC_ZERO_TIME),
+    quantum_max("quantum_max", sc_core::SC_ZERO_TIME),
+    parallel("parallel", false),
+    parallel_deterministic("parallel_deterministic", false),
+    parallel_pin("parallel_pin", true),
+    reset_in_place("reset_in_place", false),
+    tbsize("tbsize", "8MB"),
+    gicv3("gicv3", false),
+    stats_file("stats_file", ""),
+    stats_format("stats_format", "csv"),
+    stats_interval("stats_interval", sc_core::SC_ZERO_TIME),
+    snapshot_file("snapshot_file", ""),
+    snapshot_time("snapshot_time", sc_core::SC_ZERO_TIME),
+    restore_file("restore_file", ""),
+    restore_partial("restore_partial", false),
+    ram_images("ram_images"),
+    fork_children("fork_children", 0),
+    fork_time("fork_time", sc_core::SC_ZERO_TIME),
     gic_cpuif("addr_gic_cpuif", { GIC_CPUIF_LO, GIC_CPUIF_HI }),
     gic_distif("addr_gic_distif", { GIC_DISTIF_LO, GIC_DISTIF_HI }),
     gic_vifctrl("addr_gic_vifctrl", { GIC_VIFCTRL_LO, GIC_VIFCTRL_HI }),
@@ -34,15 +71,41 @@ cpu::cpu(const sc_core::sc_module_name& nm):
     bus("bus"),
     spi("spi"),
     m_cores(),
+    m_idle(ncores),
+    m_timers(),
     m_gic("gic"),
     m_corebus("corebus"),
-    m_gdb(nullptr) {
+    m_gdb(nullptr),
+    m_stats_file(),
+    m_stats_last(),
+    m_guest_memory(),
+    m_snapshot_devices(),
+    m_uncaptured_devices(),
+    m_restore(),
+    m_restored(false),
+    m_failed_children(0),
+    m_fork_id(0),
+    m_images_mapped(false),
+    m_started(false) {
+    auto& mp = mem_protector::instance();
+    if (write_tracking.get() == "userfaultfd") {
+        if (!mp.set_backend(mem_protector::BACKEND_USERFAULTFD))
+            log_warn("userfaultfd not available, using signal handler");
+    } else if (write_tracking.get() == "signal") {
+        mp.set_backend(mem_protector::BACKEND_SIGNAL);
+    } else {
+        VCML_ERROR("unknown write tracking backend: %s",
+                   write_tracking.get().c_str());
+    }
+
     m_cores.resize(ncores);
 
     // initialize cores and bind interrupts
     for (size_t id = 0; id < ncores; ++id) {
         auto nm = mwr::mkstr("arm%zu", id);
         m_cores[id] = std::make_shared<core>(nm.c_str(), clusterid, id);
+        m_cores[id]->set_idle_tracker(&m_idle);
+        m_cores[id]->use_timers(m_timers);
 
         m_cores[id]->irq[core::INTERRUPT_IRQ].bind(m_gic.irq_out[id]);
         m_cores[id]->irq[core::INTERRUPT_FIQ].bind(m_gic.fiq_out[id]);
@@ -82,6 +145,27 @@ cpu::cpu(const sc_core::sc_module_name& nm):
 
     rst.bind(m_corebus.rst);
     rst.bind(m_gic.rst);
+
+    register_command("mprotect_stats", 0, &cpu::cmd_mprotect_stats,
+                     "reports mprotect calls issued and saved by merging "
+                     "contiguous pages");
+    register_command("stats", 0, &cpu::cmd_stats,
+                     "reports hot path counters of all cores as JSON");
+    register_command("snapshot", 1, &cpu::cmd_snapshot,
+                     "saves the state of the cluster and its memory to the "
+                     "given file");
+}
+
+void cpu::reset() {
+    vcml::component::reset();
+
+    // the guest may have written to the images, so they are mapped again
+    // once the cores leave reset; the initial reset finds nothing mapped
+    if (m_images_mapped) {
+        m_images_mapped = false;
+        for (const auto& c : m_cores)
+            c->before_quantum([this]() { map_images(); });
+    }
 }
 
 void cpu::before_end_of_elaboration() {
@@ -96,6 +180,40 @@ void cpu::before_end_of_elaboration() {
 void cpu::end_of_elaboration() {
     component::end_of_elaboration();
 
+    m_timers.start("timer_trigger");
+
+    if (!stats_file.get().empty())
+        open_stats_file();
+
+    for (const auto& c : m_cores)
+        c->before_quantum([this]() { log_startup(); });
+
+    // images are mapped before any snapshot is restored on top of them
+    if (!ram_images.get().empty()) {
+        for (const auto& c : m_cores)
+            c->before_quantum([this]() { map_images(); });
+    }
+
+    if (!restore_file.get().empty())
+        load_snapshot(restore_file);
+
+    if (!snapshot_file.get().empty()) {
+        VCML_ERROR_ON(parallel && !parallel_deterministic,
+                      "snapshots require deterministic execution");
+        VCML_ERROR_ON(async, "snapshots cannot be used with async");
+        sc_core::sc_spawn(sc_bind(&cpu::snapshot_thread, this),
+                          sc_core::sc_gen_unique_name("snapshot_thread"));
+    }
+
+    if (fork_children > 0) {
+        VCML_ERROR_ON(parallel && !parallel_deterministic,
+                      "forking requires deterministic execution");
+        // the async threads of vcml are not stopped around fork()
+        VCML_ERROR_ON(async, "forking cannot be used with async");
+        sc_core::sc_spawn(sc_bind(&cpu::fork_thread, this),
+                          sc_core::sc_gen_unique_name("fork_thread"));
+    }
+
     if (gdb_port >= 0) {
         auto run = gdb_wait ? vcml::debugging::GDB_STOPPED
                             : vcml::debugging::GDB_RUNNING;
@@ -125,6 +243,28 @@ void cpu::end_of_simulation() {
 
     log_info("total - cluster %zu", clusterid.get());
     log_info("  instructions : %llu", cycle_count());
+
+    const auto& mp = mem_protector::instance();
+    log_info("  mprotect     : %llu (%llu merged)", mp.num_mprotect(),
+             mp.num_mprotect_saved());
+    log_info("  idle         : %.3f ms in %llu periods",
+             m_idle.idle_time_ps() * 1e-9, m_idle.idle_periods());
+    log_info("  timer events : %llu dispatched, %llu rescheduled",
+             m_timers.num_dispatched(), m_timers.num_rescheduled());
+
+    log_memory_usage();
+
+    if (quantum_max.get() > sc_core::SC_ZERO_TIME)
+        log_quantum_histogram();
+
+    if (m_stats_file.is_open())
+        dump_stats();
+
+    if (!coverage_file.get().empty()) {
+        coverage_map total = coverage();
+        total.save(output_file(coverage_file));
+        log_info("  coverage     : %zu blocks", total.count());
+    }
 }
 
 vcml::u64 cpu::cycle_count() const {
@@ -136,6 +276,509 @@ vcml::u64 cpu::cycle_count() const {
     return total_insn;
 }
 
+core_stats cpu::stats() const {
+    core_stats total;
+    for (const auto& c : m_cores)
+        total += c->stats();
+    return total;
+}
+
+void cpu::add_guest_memory(const vcml::range& mem) {
+    m_guest_memory.push_back(mem);
+}
+
+void cpu::add_snapshot_device(vcml::peripheral& dev) {
+    m_snapshot_devices.push_back(&dev);
+}
+
+void cpu::add_uncaptured_device(sc_core::sc_object& dev) {
+    m_uncaptured_devices.push_back(dev.name());
+}
+
+void cpu::save_snapshot(const string& path) {
+    VCML_ERROR_ON(parallel && !parallel_deterministic,
+                  "snapshots require deterministic execution");
+    VCML_ERROR_ON(async, "snapshots cannot be used with async");
+
+    double t = mwr::timestamp();
+    snapshot snap;
+    snap.create("cluster").put<vcml::u64>(m_cores.size());
+
+    for (size_t id = 0; id < m_cores.size(); ++id) {
+        core& c = *m_cores[id];
+        c.save_state(snap.create(mwr::mkstr("core%zu", id)));
+        save_gic(snap.create(mwr::mkstr("gic%zu", id)), c, true);
+    }
+
+    save_gic(snap.create("gic"), *m_cores[0], false);
+
+    for (vcml::peripheral* dev : m_snapshot_devices)
+        save_device(snap.create(mwr::mkstr("dev:%s", dev->name())), *dev);
+
+    auto& uncaptured = snap.create("uncaptured");
+    uncaptured.put<vcml::u64>(m_uncaptured_devices.size());
+    for (const string& name : m_uncaptured_devices)
+        uncaptured.put_str(name);
+
+    vcml::u64 zero_pages = 0;
+    for (const auto& mem : m_guest_memory) {
+        auto& sec = snap.create(mwr::mkstr("mem@%llx", mem.start));
+        save_memory(sec, mem);
+        zero_pages += sec.zero_pages();
+    }
+
+    snap.save(path);
+    log_info("saved snapshot '%s' in %.3fs (%llu zero pages)", path.c_str(),
+             mwr::timestamp() - t, zero_pages);
+}
+
+void cpu::load_snapshot(const string& path) {
+    m_restore.load(path);
+    m_restored = false;
+
+    vcml::u64 ncores = m_restore.section("cluster").get<vcml::u64>();
+    VCML_ERROR_ON(ncores != m_cores.size(),
+                  "snapshot '%s' was taken with %llu cores", path.c_str(),
+                  ncores);
+
+    auto& uncaptured = m_restore.section("uncaptured");
+    vcml::u64 nuncaptured = uncaptured.get<vcml::u64>();
+    for (vcml::u64 i = 0; i < nuncaptured; ++i) {
+        string name = uncaptured.get_str();
+        VCML_ERROR_ON(!restore_partial,
+                      "snapshot '%s' lacks the internal state of %s, set "
+                      "restore_partial to restore it anyway",
+                      path.c_str(), name.c_str());
+        log_warn("%s restarts from its saved registers only", name.c_str());
+    }
+
+    for (vcml::peripheral* dev : m_snapshot_devices) {
+        string name = mwr::mkstr("dev:%s", dev->name());
+        VCML_ERROR_ON(!m_restore.has_section(name),
+                      "snapshot '%s' has no state for %s", path.c_str(),
+                      dev->name());
+    }
+
+    // resets happen after elaboration, so the state is only applied when
+    // the cores start running; the first core restores memory and GIC
+    for (size_t id = 0; id < m_cores.size(); ++id) {
+        m_cores[id]->before_quantum([this, id]() {
+            restore_shared_state();
+            auto& sec = m_restore.section(mwr::mkstr("core%zu", id));
+            m_cores[id]->restore_state(sec);
+        });
+    }
+}
+
+vector<vcml::u64> cpu::gic_registers(bool banked) const {
+    const vcml::u64 dist = gic_distif.get().start;
+    const vcml::u64 cpuif = gic_cpuif.get().start;
+    const size_t nirq = vcml::arm::gic400::NSPI + 32;
+
+    vector<vcml::u64> regs;
+    auto add = [&](vcml::u64 base, size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i)
+            regs.push_back(base + 4 * i);
+    };
+
+    // pending and active states are not saved, they follow from the
+    // interrupt lines once devices and timers run again
+    if (banked) {
+        add(dist + GICD_IGROUPR, 0, 1);
+        add(dist + GICD_ISENABLER, 0, 1);
+        add(dist + GICD_IPRIORITYR, 0, 8);
+        add(dist + GICD_ICFGR, 1, 2);
+        regs.push_back(cpuif + GICC_PMR);
+        regs.push_back(cpuif + GICC_BPR);
+        regs.push_back(cpuif + GICC_ABPR);
+        regs.push_back(cpuif + GICC_CTLR);
+    } else {
+        add(dist + GICD_IGROUPR, 1, (nirq + 31) / 32);
+        add(dist + GICD_ISENABLER, 1, (nirq + 31) / 32);
+        add(dist + GICD_IPRIORITYR, 8, (nirq + 3) / 4);
+        add(dist + GICD_ITARGETSR, 8, (nirq + 3) / 4);
+        add(dist + GICD_ICFGR, 2, (nirq + 15) / 16);
+        regs.push_back(dist + GICD_CTLR);
+    }
+
+    return regs;
+}
+
+void cpu::save_gic(snapshot_section& sec, core& c, bool banked) {
+    // banked registers are selected by the cpu id of the core's socket
+    vector<vcml::u64> regs = gic_registers(banked);
+    sec.put<vcml::u64>(regs.size());
+    for (vcml::u64 addr : regs) {
+        vcml::u32 val = 0;
+        c.data.read(addr, &val, sizeof(val), vcml::SBI_DEBUG);
+        sec.put(addr);
+        sec.put(val);
+    }
+}
+
+void cpu::restore_gic(snapshot_section& sec, core& c) {
+    const vcml::u64 dist = gic_distif.get().start;
+    vcml::u64 nregs = sec.get<vcml::u64>();
+    for (vcml::u64 i = 0; i < nregs; ++i) {
+        vcml::u64 addr = sec.get<vcml::u64>();
+        vcml::u32 val = sec.get<vcml::u32>();
+
+        // set-enable registers only set bits, clear all of them first
+        if (addr >= dist + GICD_ISENABLER && addr < dist + GICD_ICENABLER) {
+            vcml::u32 all = ~0u;
+            vcml::u64 clear = addr + GICD_ICENABLER - GICD_ISENABLER;
+            c.data.write(clear, &all, sizeof(all), vcml::SBI_DEBUG);
+        }
+
+        c.data.write(addr, &val, sizeof(val), vcml::SBI_DEBUG);
+    }
+}
+
+void cpu::save_memory(snapshot_section& sec, const vcml::range& mem) {
+    vector<vcml::u8> buf(1 * mwr::MiB);
+    core& c = *m_cores[0];
+    for (vcml::u64 addr = mem.start; addr <= mem.end; addr += buf.size()) {
+        size_t len = std::min<vcml::u64>(buf.size(), mem.end - addr + 1);
+        VCML_ERROR_ON(c.data.read(addr, buf.data(), len, vcml::SBI_DEBUG) !=
+                          tlm::TLM_OK_RESPONSE,
+                      "cannot read memory at 0x%llx", addr);
+        sec.write_pages(buf.data(), len);
+    }
+}
+
+void cpu::restore_memory(snapshot_section& sec, const vcml::range& mem) {
+    vector<vcml::u8> buf(1 * mwr::MiB);
+    core& c = *m_cores[0];
+    for (vcml::u64 addr = mem.start; addr <= mem.end; addr += buf.size()) {
+        size_t len = std::min<vcml::u64>(buf.size(), mem.end - addr + 1);
+        sec.read_pages(buf.data(), len);
+        VCML_ERROR_ON(c.data.write(addr, buf.data(), len, vcml::SBI_DEBUG) !=
+                          tlm::TLM_OK_RESPONSE,
+                      "cannot write memory at 0x%llx", addr);
+    }
+}
+
+void cpu::save_device(snapshot_section& sec, vcml::peripheral& dev) {
+    auto regs = dev.get_registers();
+    sec.put<vcml::u64>(regs.size());
+    for (vcml::reg_base* reg : regs) {
+        sec.put_str(reg->name());
+        sec.put_str(reg->str());
+    }
+}
+
+void cpu::restore_device(snapshot_section& sec, vcml::peripheral& dev) {
+    std::map<string, vcml::reg_base*> regs;
+    for (vcml::reg_base* reg : dev.get_registers())
+        regs[reg->name()] = reg;
+
+    // values are set directly, without triggering register callbacks
+    vcml::u64 nregs = sec.get<vcml::u64>();
+    for (vcml::u64 i = 0; i < nregs; ++i) {
+        string name = sec.get_str();
+        string value = sec.get_str();
+        auto it = regs.find(name);
+        VCML_ERROR_ON(it == regs.end(), "snapshot register %s not found",
+                      name.c_str());
+        it->second->str(value);
+    }
+}
+
+void cpu::restore_shared_state() {
+    if (m_restored)
+        return;
+
+    m_restored = true;
+    double t = mwr::timestamp();
+
+    for (const auto& mem : m_guest_memory) {
+        string name = mwr::mkstr("mem@%llx", mem.start);
+        if (m_restore.has_section(name))
+            restore_memory(m_restore.section(name), mem);
+        else
+            log_warn("snapshot has no contents for memory %s", name.c_str());
+    }
+
+    restore_gic(m_restore.section("gic"), *m_cores[0]);
+    for (size_t id = 0; id < m_cores.size(); ++id) {
+        auto& sec = m_restore.section(mwr::mkstr("gic%zu", id));
+        restore_gic(sec, *m_cores[id]);
+    }
+
+    for (vcml::peripheral* dev : m_snapshot_devices) {
+        auto& sec = m_restore.section(mwr::mkstr("dev:%s", dev->name()));
+        restore_device(sec, *dev);
+    }
+
+    log_info("restored memory, GIC and device state in %.3fs",
+             mwr::timestamp() - t);
+}
+
+vcml::u8* cpu::host_memory(vcml::u64 addr, vcml::u64& end) {
+    tlm::tlm_generic_payload tx;
+    tlm::tlm_dmi dmi;
+    tx.set_address(addr);
+    tx.set_data_length(1);
+    tx.set_streaming_width(1);
+    tx.set_write();
+
+    core& c = *m_cores[0];
+    if (!c.data->get_direct_mem_ptr(tx, dmi) || !dmi.is_write_allowed())
+        return nullptr;
+
+    end = dmi.get_end_address();
+    return dmi.get_dmi_ptr() + addr - dmi.get_start_address();
+}
+
+// the images property of vcml::generic::memory cannot be used here, since
+// it reads every image into memory during reset; these images are mapped
+// instead, so that only the pages the guest touches are read from disk,
+// mapping again on reset discards everything the guest wrote to them
+void cpu::map_images() {
+    if (m_images_mapped)
+        return;
+
+    m_images_mapped = true;
+    for (const string& image : ram_images.get()) {
+        size_t sep = image.rfind('@');
+        VCML_ERROR_ON(sep == string::npos,
+                      "invalid ram image '%s', expected <file>@<address>",
+                      image.c_str());
+
+        string path = image.substr(0, sep);
+        vcml::u64 addr = std::stoull(image.substr(sep + 1), nullptr, 0);
+
+        // mapped images are only read from disk when the guest touches them
+        vcml::u64 end = 0;
+        vcml::u8* host = host_memory(addr, end);
+        size_t size = host ? map_file(host, end - addr + 1, path) : 0;
+        if (size > 0) {
+            log_debug("mapped %s to 0x%llx (%zu bytes)", path.c_str(), addr,
+                      size);
+            continue;
+        }
+
+        std::ifstream is(path, std::ios::binary);
+        VCML_ERROR_ON(!is, "cannot open ram image '%s'", path.c_str());
+        vector<char> buf((std::istreambuf_iterator<char>(is)),
+                         std::istreambuf_iterator<char>());
+        VCML_ERROR_ON(m_cores[0]->data.write(addr, buf.data(), buf.size(),
+                                             vcml::SBI_DEBUG) !=
+                          tlm::TLM_OK_RESPONSE,
+                      "cannot load ram image '%s' to 0x%llx", path.c_str(),
+                      addr);
+        log_debug("copied %s to 0x%llx (%zu bytes)", path.c_str(), addr,
+                  buf.size());
+    }
+}
+
+void cpu::log_memory_usage() {
+    for (const auto& mem : m_guest_memory) {
+        vcml::u64 end = 0;
+        vcml::u8* host = host_memory(mem.start, end);
+        if (!host || end < mem.end)
+            continue;
+
+        size_t resident = resident_size(host, mem.length());
+        log_info("  memory       : 0x%llx %.1f of %.1f MiB resident",
+                 mem.start, resident * 1.0 / mwr::MiB,
+                 mem.length() * 1.0 / mwr::MiB);
+    }
+}
+
+// host time of the static initialization of the simulator, i.e. right after
+// exec and dynamic linking
+static const std::chrono::steady_clock::time_point g_start_time =
+    std::chrono::steady_clock::now();
+
+static double process_age() {
+    auto age = std::chrono::steady_clock::now() - g_start_time;
+    return std::chrono::duration<double>(age).count();
+}
+
+void cpu::log_startup() {
+    if (m_started)
+        return;
+
+    m_started = true;
+    log_debug("first instruction after %.6fs", process_age());
+}
+
+void cpu::snapshot_thread() {
+    sc_core::wait(snapshot_time.get());
+    save_snapshot(snapshot_file);
+}
+
+size_t cpu::fork_simulation(size_t n) {
+    // buffered output would otherwise be written by every child again
+    std::fflush(nullptr);
+    if (m_stats_file.is_open())
+        m_stats_file.flush();
+
+    // guest memory is mapped privately, so every child works on its own
+    // copy-on-write view of the state at this point
+    auto& mp = mem_protector::instance();
+    for (const auto& c : m_cores)
+        c->before_fork();
+
+    vector<pid_t> children;
+    for (size_t id = 1; id <= n; ++id) {
+        mp.before_fork();
+        pid_t pid = ::fork();
+        mp.after_fork(pid == 0);
+        VCML_ERROR_ON(pid < 0, "fork: %s", std::strerror(errno));
+
+        if (pid == 0) {
+            // outputs of the children carry their index as a suffix
+            m_fork_id = id;
+            for (const auto& c : m_cores)
+                c->after_fork(id);
+
+            if (m_stats_file.is_open()) {
+                m_stats_file.close();
+                open_stats_stream();
+            }
+
+            ::setenv("AVP64_FORK_ID", std::to_string(id).c_str(), 1);
+            log_info("forked child %zu of %zu", id, n);
+            return id;
+        }
+
+        children.push_back(pid);
+    }
+
+    for (const auto& c : m_cores)
+        c->after_fork(0);
+
+    for (size_t i = 0; i < children.size(); ++i) {
+        int status = 0;
+        while (::waitpid(children[i], &status, 0) < 0 && errno == EINTR)
+            continue;
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            log_error("child %zu (pid %d) failed", i + 1, children[i]);
+            m_failed_children++;
+        }
+    }
+
+    log_info("%zu of %zu children succeeded", n - m_failed_children, n);
+    return 0;
+}
+
+void cpu::fork_thread() {
+    sc_core::wait(fork_time.get());
+    if (fork_simulation(fork_children) == 0)
+        sc_core::sc_stop();
+}
+
+void cpu::log_quantum_histogram() const {
+    quantum_controller::histogram total{};
+    for (const auto& c : m_cores) {
+        const auto& quanta = c->quantum().quanta();
+        for (size_t i = 0; i < total.size(); ++i)
+            total[i] += quanta[i];
+    }
+
+    log_info("  quantum size histogram (cycles)");
+    for (size_t i = 0; i < total.size(); ++i) {
+        if (total[i] == 0)
+            continue;
+
+        vcml::u64 lo = 1ull << i;
+        log_info("    %llu..%llu : %llu", lo, lo + (lo - 1), total[i]);
+    }
+}
+
+coverage_map cpu::coverage() const {
+    coverage_map total;
+    for (const auto& c : m_cores)
+        total.merge(c->coverage());
+    return total;
+}
+
+void cpu::open_stats_file() {
+    VCML_ERROR_ON(stats_format.get() != "csv" && stats_format.get() != "json",
+                  "unknown stats format: %s", stats_format.get().c_str());
+
+    open_stats_stream();
+    m_stats_last.resize(m_cores.size());
+
+    if (stats_interval.get() > sc_core::SC_ZERO_TIME) {
+        sc_core::sc_spawn(sc_bind(&cpu::stats_thread, this),
+                          sc_core::sc_gen_unique_name("stats_thread"));
+    }
+}
+
+void cpu::open_stats_stream() {
+    const string path = output_file(stats_file);
+    m_stats_file.open(path);
+    VCML_ERROR_ON(!m_stats_file.is_open(), "cannot open stats file '%s'",
+                  path.c_str());
+
+    if (stats_format.get() == "csv")
+        m_stats_file << "time_ps,core," << core_stats::csv_header() << "\n";
+}
+
+string cpu::output_file(const string& base) const {
+    return m_fork_id ? mwr::mkstr("%s.%zu", base.c_str(), m_fork_id) : base;
+}
+
+void cpu::dump_stats() {
+    // every dump contains the counters of the interval since the last one
+    vcml::u64 now = vcml::time_to_ps(sc_core::sc_time_stamp());
+    vector<core_stats> deltas;
+    core_stats total;
+    for (size_t i = 0; i < m_cores.size(); ++i) {
+        const core_stats& current = m_cores[i]->stats();
+        deltas.push_back(current - m_stats_last[i]);
+        m_stats_last[i] = current;
+        total += deltas.back();
+    }
+
+    if (stats_format.get() == "csv") {
+        for (size_t i = 0; i < deltas.size(); ++i) {
+            m_stats_file << now << "," << i << "," << deltas[i].to_csv()
+                         << "\n";
+        }
+
+        m_stats_file << now << ",total," << total.to_csv() << "\n";
+    } else {
+        m_stats_file << "{\"time_ps\":" << now << ",\"cores\":[";
+        for (size_t i = 0; i < deltas.size(); ++i)
+            m_stats_file << (i ? "," : "") << deltas[i].to_json();
+        m_stats_file << "],\"total\":" << total.to_json() << "}\n";
+    }
+
+    m_stats_file.flush();
+}
+
+void cpu::stats_thread() {
+    while (true) {
+        sc_core::wait(stats_interval.get());
+        dump_stats();
+    }
+}
+
+bool cpu::cmd_stats(const vector<string>& args, std::ostream& os) {
+    for (const auto& c : m_cores)
+        os << c->name() << ": " << c->stats().to_json() << std::endl;
+    os << "total: " << stats().to_json();
+    return true;
+}
+
+bool cpu::cmd_snapshot(const vector<string>& args, std::ostream& os) {
+    save_snapshot(args[0]);
+    os << "saved snapshot to " << args[0];
+    return true;
+}
+
+bool cpu::cmd_mprotect_stats(const vector<string>& args, std::ostream& os) {
+    const auto& mp = mem_protector::instance();
+    os << "mprotect calls: " << mp.num_mprotect() << std::endl;
+    os << "mprotect merged: " << mp.num_mprotect_saved();
+    return true;
+}
+
 const char* cpu::version() const {
     return AVP64_VERSION_STRING;
 }
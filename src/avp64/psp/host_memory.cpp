@@ -0,0 +1,67 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/host_memory.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace avp64 {
+namespace psp {
+
+size_t map_file(vcml::u8* host, size_t limit, const string& path) {
+    const vcml::u64 page_size = mwr::get_page_size();
+    if (reinterpret_cast<vcml::u64>(host) & (page_size - 1))
+        return 0;
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+
+    struct stat st {};
+    size_t size = 0;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0 &&
+        static_cast<size_t>(st.st_size) <= limit) {
+        size = st.st_size;
+    }
+
+    // the rest of the last page reads as zero, the mapping stays valid
+    // after closing the file
+    if (size > 0 && ::mmap(host, size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        size = 0;
+    }
+
+    ::close(fd);
+    return size;
+}
+
+size_t resident_size(const vcml::u8* host, size_t size) {
+    if (size == 0)
+        return 0;
+
+    const vcml::u64 page_size = mwr::get_page_size();
+    vcml::u64 start = reinterpret_cast<vcml::u64>(host) & ~(page_size - 1);
+    vcml::u64 end = reinterpret_cast<vcml::u64>(host) + size;
+    size_t npages = (end - start + page_size - 1) / page_size;
+
+    vector<unsigned char> vec(npages);
+    if (::mincore(reinterpret_cast<void*>(start), end - start, vec.data()))
+        return 0;
+
+    size_t resident = 0;
+    for (unsigned char v : vec)
+        resident += v & 1;
+    return resident * page_size;
+}
+
+} // namespace psp
+} // namespace avp64
@@ -0,0 +1,120 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/host_page_table.h"
+
+namespace avp64 {
+namespace psp {
+
+void target_page_list::push_back(const target_page_data& tp) {
+    if (m_size < INLINE_SLOTS) {
+        m_inline[m_size++] = tp;
+        return;
+    }
+
+    if (!m_spill)
+        m_spill = std::make_unique<vector<target_page_data>>();
+
+    m_spill->push_back(tp);
+    m_size++;
+}
+
+void target_page_list::pop_back() {
+    VCML_ERROR_ON(m_size == 0, "target page list is empty");
+
+    if (m_size > INLINE_SLOTS)
+        m_spill->pop_back();
+
+    m_size--;
+}
+
+host_page_table::host_page_table(vcml::u64 page_bits):
+    m_page_bits(page_bits), m_slots(), m_mask(0), m_shift(0), m_size(0) {
+    rehash(MIN_CAPACITY);
+}
+
+size_t host_page_table::probe(vcml::u64 key) const {
+    size_t idx = home(key);
+    while (m_slots[idx].key != key && m_slots[idx].key != EMPTY)
+        idx = (idx + 1) & m_mask;
+    return idx;
+}
+
+host_page_data* host_page_table::find(const void* page) {
+    size_t idx = probe(key_of(page));
+    return m_slots[idx].key == EMPTY ? nullptr : &m_slots[idx].data;
+}
+
+host_page_data& host_page_table::insert(const void* page) {
+    vcml::u64 key = key_of(page);
+    size_t idx = probe(key);
+    if (m_slots[idx].key == key)
+        return m_slots[idx].data;
+
+    // keep the load factor below 1/2 so that probe sequences stay short
+    if (2 * (m_size + 1) > m_slots.size()) {
+        rehash(2 * m_slots.size());
+        idx = probe(key);
+    }
+
+    m_slots[idx].key = key;
+    m_size++;
+    return m_slots[idx].data;
+}
+
+bool host_page_table::erase(const void* page) {
+    size_t idx = probe(key_of(page));
+    if (m_slots[idx].key == EMPTY)
+        return false;
+
+    // backward shift deletion: move up entries of the same probe sequence
+    size_t next = idx;
+    while (true) {
+        next = (next + 1) & m_mask;
+        if (m_slots[next].key == EMPTY)
+            break;
+
+        size_t h = home(m_slots[next].key);
+        bool movable = idx <= next ? (h <= idx || h > next)
+                                   : (h <= idx && h > next);
+        if (movable) {
+            m_slots[idx] = std::move(m_slots[next]);
+            idx = next;
+        }
+    }
+
+    m_slots[idx] = slot();
+    m_size--;
+    return true;
+}
+
+void host_page_table::clear() {
+    m_slots.clear();
+    m_size = 0;
+    rehash(MIN_CAPACITY);
+}
+
+void host_page_table::rehash(size_t capacity) {
+    vector<slot> old(capacity);
+    old.swap(m_slots);
+
+    m_mask = capacity - 1;
+    m_shift = 64 - mwr::ctz(capacity);
+
+    for (auto& s : old) {
+        if (s.key == EMPTY)
+            continue;
+
+        size_t idx = probe(s.key);
+        m_slots[idx] = std::move(s);
+    }
+}
+
+} // namespace psp
+} // namespace avp64
@@ -0,0 +1,58 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/idle_tracker.h"
+
+namespace avp64 {
+namespace psp {
+
+idle_tracker::idle_tracker(size_t ncores):
+    m_mtx(),
+    m_idle(ncores, false),
+    m_num_idle(0),
+    m_idle_since(0),
+    m_idle_periods(0),
+    m_idle_time(0) {
+}
+
+void idle_tracker::enter(size_t core, vcml::u64 now_ps) {
+    std::lock_guard<std::mutex> guard(m_mtx);
+    VCML_ERROR_ON(core >= m_idle.size(), "invalid core %zu", core);
+    if (!m_idle[core]) {
+        m_idle[core] = true;
+        if (++m_num_idle == m_idle.size()) {
+            m_idle_since = now_ps;
+            m_idle_periods++;
+        }
+    }
+}
+
+void idle_tracker::leave(size_t core, vcml::u64 now_ps) {
+    std::lock_guard<std::mutex> guard(m_mtx);
+    VCML_ERROR_ON(core >= m_idle.size(), "invalid core %zu", core);
+    if (m_idle[core]) {
+        if (m_num_idle == m_idle.size())
+            m_idle_time += now_ps - m_idle_since;
+        m_idle[core] = false;
+        m_num_idle--;
+    }
+}
+
+vcml::u64 idle_tracker::idle_periods() const {
+    std::lock_guard<std::mutex> guard(m_mtx);
+    return m_idle_periods;
+}
+
+vcml::u64 idle_tracker::idle_time_ps() const {
+    std::lock_guard<std::mutex> guard(m_mtx);
+    return m_idle_time;
+}
+
+} // namespace psp
+} // namespace avp64
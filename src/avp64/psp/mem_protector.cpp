@@ -10,6 +10,18 @@
 #include "avp64/psp/mem_protector.h"
 
 #include <sys/mman.h>
+#include <algorithm>
+
+#if __has_include(<linux/userfaultfd.h>)
+#include <linux/userfaultfd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#define AVP64_HAVE_USERFAULTFD
+#endif
 
 namespace avp64 {
 namespace psp {
@@ -17,18 +29,103 @@ namespace psp {
 const vcml::u64 mem_protector::HOST_PAGE_BITS = mwr::ctz(mwr::get_page_size());
 const vcml::u64 mem_protector::HOST_PAGE_MASK = ~(mwr::get_page_size() - 1);
 
-mem_protector::mem_protector(): m_protected_pages() {
+// calls func(host_page) for every host page backing the given target page;
+// target pages may be smaller or larger than host pages
+template <typename FUNC>
+static void for_each_host_page(const void* host_addr, vcml::u64 size,
+                               vcml::u64 host_page_mask, FUNC func) {
+    vcml::u64 addr = reinterpret_cast<vcml::u64>(host_addr);
+    vcml::u64 first = addr & host_page_mask;
+    vcml::u64 last = (addr + size - 1) & host_page_mask;
+    for (vcml::u64 page = first; page <= last; page += ~host_page_mask + 1)
+        func(reinterpret_cast<void*>(page));
+}
+
+mem_protector::mem_protector():
+    m_mtx(),
+    m_owner(),
+    m_protected_pages(HOST_PAGE_BITS),
+    m_target_pages(),
+    m_recent(),
+    m_recent_idx(0),
+    m_num_mprotect(0),
+    m_num_mprotect_saved(0),
+    m_backend(BACKEND_SIGNAL),
+    m_handler_installed(false),
+    m_sa_orig(),
+    m_uffd(-1),
+    m_uffd_stop(-1),
+    m_uffd_thread() {
+    install_handler();
+}
+
+mem_protector::~mem_protector() {
+    uffd_close();
+    remove_handler();
+}
+
+void mem_protector::lock() {
+    m_mtx.lock();
+    m_owner = std::this_thread::get_id();
+}
+
+void mem_protector::unlock() {
+    m_owner = std::thread::id();
+    m_mtx.unlock();
+}
+
+bool mem_protector::locked_by_self() const {
+    return m_owner == std::this_thread::get_id();
+}
+
+void mem_protector::install_handler() {
+    if (m_handler_installed)
+        return;
+
     struct sigaction sa;
     sa.sa_flags = SA_SIGINFO;
     ::sigemptyset(&sa.sa_mask);
     sa.sa_sigaction = segfault_handler;
     VCML_ERROR_ON(::sigaction(SIGSEGV, &sa, &m_sa_orig) != 0, "sigaction: %s",
                   std::strerror(errno));
+    m_handler_installed = true;
 }
 
-mem_protector::~mem_protector() {
+void mem_protector::remove_handler() {
+    if (!m_handler_installed)
+        return;
+
     VCML_ERROR_ON(::sigaction(SIGSEGV, &m_sa_orig, nullptr) != 0,
                   "sigaction: %s", std::strerror(errno));
+    m_handler_installed = false;
+}
+
+bool mem_protector::set_backend(backend_kind backend) {
+    page_guard guard(*this);
+    if (backend == m_backend)
+        return true;
+
+    VCML_ERROR_ON(!m_protected_pages.empty(),
+                  "cannot change backend while pages are protected");
+
+    switch (backend) {
+    case BACKEND_SIGNAL:
+        uffd_close();
+        install_handler();
+        break;
+
+    case BACKEND_USERFAULTFD:
+        if (!uffd_open())
+            return false;
+        remove_handler();
+        break;
+
+    default:
+        return false;
+    }
+
+    m_backend = backend;
+    return true;
 }
 
 void mem_protector::segfault_handler(int sig, siginfo_t* si, void* arg) {
@@ -37,132 +134,488 @@ void mem_protector::segfault_handler(int sig, siginfo_t* si, void* arg) {
 }
 
 void mem_protector::segfault_handler_int(int sig, siginfo_t* si, void* arg) {
-    if (!notify_page(si->si_addr))
+    // faults while holding the lock are never caused by protected pages
+    if (locked_by_self() || !notify_page(si->si_addr))
+        forward_signal(sig, si, arg);
+}
+
+void mem_protector::forward_signal(int sig, siginfo_t* si, void* arg) {
+    if (m_sa_orig.sa_flags & SA_SIGINFO) {
         m_sa_orig.sa_sigaction(sig, si, arg);
+        return;
+    }
+
+    if (m_sa_orig.sa_handler != SIG_DFL && m_sa_orig.sa_handler != SIG_IGN) {
+        m_sa_orig.sa_handler(sig);
+        return;
+    }
+
+    // restore the default action; the faulting access is repeated after
+    // returning and then terminates the process as usual
+    ::sigaction(SIGSEGV, &m_sa_orig, nullptr);
+    m_handler_installed = false;
+}
+
+#ifdef AVP64_HAVE_USERFAULTFD
+
+bool mem_protector::uffd_open() {
+    if (m_uffd >= 0)
+        return true;
+
+    int fd = ::syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+#ifdef UFFD_USER_MODE_ONLY
+    // unprivileged processes may only handle faults from user mode
+    if (fd < 0) {
+        fd = ::syscall(SYS_userfaultfd,
+                       O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY);
+    }
+#endif
+    if (fd < 0)
+        return false;
+
+    struct uffdio_api api = {};
+    api.api = UFFD_API;
+    api.features = UFFD_FEATURE_PAGEFAULT_FLAG_WP;
+    if (::ioctl(fd, UFFDIO_API, &api) != 0 ||
+        !(api.features & UFFD_FEATURE_PAGEFAULT_FLAG_WP)) {
+        ::close(fd);
+        return false;
+    }
+
+    int stop = ::eventfd(0, EFD_CLOEXEC);
+    if (stop < 0) {
+        ::close(fd);
+        return false;
+    }
+
+    m_uffd = fd;
+    m_uffd_stop = stop;
+    m_uffd_thread = std::thread(&mem_protector::uffd_handler, this);
+    return true;
+}
+
+void mem_protector::uffd_close() {
+    if (m_uffd < 0)
+        return;
+
+    uffd_stop_thread();
+    ::close(m_uffd);
+    ::close(m_uffd_stop);
+    m_uffd = -1;
+    m_uffd_stop = -1;
+}
+
+void mem_protector::uffd_stop_thread() {
+    vcml::u64 one = 1;
+    if (::write(m_uffd_stop, &one, sizeof(one)) == sizeof(one) &&
+        m_uffd_thread.joinable()) {
+        m_uffd_thread.join();
+    }
+
+    // rearm the stop event for the next handler thread
+    vcml::u64 val = 0;
+    while (::read(m_uffd_stop, &val, sizeof(val)) < 0 && errno == EINTR)
+        continue;
+}
+
+void mem_protector::uffd_handler() {
+    struct pollfd fds[2] = { { m_uffd, POLLIN, 0 }, { m_uffd_stop, POLLIN, 0 } };
+    while (true) {
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        if (fds[1].revents)
+            break;
+
+        struct uffd_msg msg;
+        if (::read(m_uffd, &msg, sizeof(msg)) != sizeof(msg))
+            continue;
+
+        if (msg.event != UFFD_EVENT_PAGEFAULT ||
+            !(msg.arg.pagefault.flags & UFFD_PAGEFAULT_FLAG_WP)) {
+            continue;
+        }
+
+        void* addr = reinterpret_cast<void*>(msg.arg.pagefault.address);
+        if (!notify_page(addr)) {
+            // not a page of ours, but the writer must not block forever
+            void* page = reinterpret_cast<void*>(
+                reinterpret_cast<vcml::u64>(addr) & HOST_PAGE_MASK);
+            uffd_protect(page, 1, false);
+        }
+    }
+}
+
+bool mem_protector::uffd_protect(void* addr, size_t npages, bool wp,
+                                 bool wake) {
+    vcml::u64 start = reinterpret_cast<vcml::u64>(addr);
+    vcml::u64 len = npages * mwr::get_page_size();
+
+    if (wp) {
+        // registering a range that is already registered is a no-op
+        struct uffdio_register reg = {};
+        reg.range.start = start;
+        reg.range.len = len;
+        reg.mode = UFFDIO_REGISTER_MODE_WP;
+        if (::ioctl(m_uffd, UFFDIO_REGISTER, &reg) != 0)
+            return false;
+    }
+
+    // clearing write protection also wakes up blocked writers
+    struct uffdio_writeprotect wprot = {};
+    wprot.range.start = start;
+    wprot.range.len = len;
+    wprot.mode = wp ? UFFDIO_WRITEPROTECT_MODE_WP : 0;
+    if (!wake)
+        wprot.mode |= UFFDIO_WRITEPROTECT_MODE_DONTWAKE;
+    return ::ioctl(m_uffd, UFFDIO_WRITEPROTECT, &wprot) == 0;
+}
+
+void mem_protector::uffd_wake(void* addr, size_t npages) {
+    struct uffdio_range range = {};
+    range.start = reinterpret_cast<vcml::u64>(addr);
+    range.len = npages * mwr::get_page_size();
+    ::ioctl(m_uffd, UFFDIO_WAKE, &range);
+}
+
+#else
+
+bool mem_protector::uffd_open() {
+    return false;
+}
+
+void mem_protector::uffd_close() {
+    // nothing to do
+}
+
+void mem_protector::uffd_stop_thread() {
+    // nothing to do
+}
+
+void mem_protector::uffd_handler() {
+    // nothing to do
+}
+
+bool mem_protector::uffd_protect(void* addr, size_t npages, bool wp,
+                                 bool wake) {
+    return false;
+}
+
+void mem_protector::uffd_wake(void* addr, size_t npages) {
+    // nothing to do
+}
+
+#endif
+
+// calls func(addr, npages) for every run of contiguous host pages
+template <typename FUNC>
+static void for_each_page_run(std::vector<void*>& pages, FUNC func) {
+    std::sort(pages.begin(), pages.end());
+    pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+    const vcml::u64 host_page_size = mwr::get_page_size();
+    for (size_t i = 0; i < pages.size();) {
+        size_t n = 1;
+        vcml::u64 base = reinterpret_cast<vcml::u64>(pages[i]);
+        while (i + n < pages.size() &&
+               reinterpret_cast<vcml::u64>(pages[i + n]) ==
+                   base + n * host_page_size) {
+            n++;
+        }
+
+        func(pages[i], n);
+        i += n;
+    }
 }
 
 void mem_protector::register_page(mem_protector_if* core, vcml::u64 page_addr,
                                   void* host_addr) {
     vcml::u64 target_page_size = core->page_size();
-    VCML_ERROR_ON(
-        mwr::get_page_size() < target_page_size,
-        "host page size is smaller than the target one - not implemented");
     VCML_ERROR_ON(target_page_size == 0, "page size is 0");
 
-    void* host_page_addr = reinterpret_cast<void*>(
-        reinterpret_cast<vcml::u64>(host_addr) & HOST_PAGE_MASK);
-
-    auto& host_page = m_protected_pages[host_page_addr];
-    bool target_page_found = false;
+    target_page_data tp{ core, page_addr, target_page_size, host_addr };
+    page_guard guard(*this);
+    std::vector<void*> pages;
+    register_page_locked(tp, pages);
+    for_each_page_run(pages, [&](void* addr, size_t npages) {
+        VCML_ERROR_ON(!protect_pages(addr, npages),
+                      "failed to protect page: %s", std::strerror(errno));
+    });
+}
 
-    for (auto& tp : host_page.target_pages) {
-        if (tp.host_address == host_addr) {
-            VCML_ERROR_ON(tp.page_addr != page_addr,
+// every core owns its own entry, so that writes only notify the cores that
+// actually registered the page
+static bool find_target_page(const host_page_data& host_page,
+                             const target_page_data& tp) {
+    for (size_t i = 0; i < host_page.target_pages.size(); ++i) {
+        const auto& other = host_page.target_pages[i];
+        if (other.c == tp.c && other.host_address == tp.host_address) {
+            VCML_ERROR_ON(other.page_addr != tp.page_addr,
                           "page_addr do not match! %llu vs. %llu",
-                          tp.page_addr, page_addr);
-            if (host_page.locked)
-                return;
-
-            target_page_found = true;
+                          other.page_addr, tp.page_addr);
+            return true;
         }
     }
 
-    if (!target_page_found) {
-        host_page.target_pages.emplace_back(
-            target_page_data{ core, page_addr, target_page_size, host_addr });
-    }
+    return false;
+}
 
-    VCML_ERROR_ON(!protect_page(host_addr), "failed to protect page: %s",
-                  std::strerror(errno));
-    host_page.locked = true;
+void mem_protector::register_page_locked(const target_page_data& tp,
+                                         std::vector<void*>& protect) {
+    void* first_page = reinterpret_cast<void*>(
+        reinterpret_cast<vcml::u64>(tp.host_address) & HOST_PAGE_MASK);
+
+    // indexing may release other host pages, so insert afterwards
+    host_page_data* known_page = m_protected_pages.find(first_page);
+    if (!known_page || !find_target_page(*known_page, tp))
+        index_target_page(tp);
+
+    auto lock_page = [&](void* page_addr) {
+        auto& host_page = m_protected_pages.insert(page_addr);
+        if (!find_target_page(host_page, tp)) {
+            VCML_ERROR_ON(host_page.target_pages.size() >= MAX_SHARED_PAGES,
+                          "more than %zu target pages share host page %p",
+                          MAX_SHARED_PAGES, page_addr);
+            host_page.target_pages.push_back(tp);
+        }
+
+        if (!host_page.locked) {
+            host_page.locked = true;
+            protect.push_back(page_addr);
+        }
+    };
+
+    for_each_host_page(tp.host_address, tp.page_size, HOST_PAGE_MASK,
+                       lock_page);
 }
 
-bool mem_protector::protect_page(void* addr) {
+bool mem_protector::protect_pages(void* addr, size_t npages) {
     VCML_ERROR_ON(reinterpret_cast<vcml::u64>(addr) & ~HOST_PAGE_MASK,
                   "invalid page address: %llu",
                   reinterpret_cast<vcml::u64>(addr));
-    return ::mprotect(addr, mwr::get_page_size(), PROT_READ) == 0;
+    m_num_mprotect++;
+    m_num_mprotect_saved += npages - 1;
+    if (m_backend == BACKEND_USERFAULTFD)
+        return uffd_protect(addr, npages, true);
+    return ::mprotect(addr, npages * mwr::get_page_size(), PROT_READ) == 0;
 }
 
-bool mem_protector::unprotect_page(void* addr) {
+bool mem_protector::unprotect_pages(void* addr, size_t npages, bool wake) {
     VCML_ERROR_ON(reinterpret_cast<vcml::u64>(addr) & ~HOST_PAGE_MASK,
                   "invalid page address: %llu",
                   reinterpret_cast<vcml::u64>(addr));
-    return ::mprotect(addr, mwr::get_page_size(), PROT_READ | PROT_WRITE) == 0;
+    m_num_mprotect++;
+    m_num_mprotect_saved += npages - 1;
+    remember_unprotected(addr, npages);
+    if (m_backend == BACKEND_USERFAULTFD)
+        return uffd_protect(addr, npages, false, wake);
+    return ::mprotect(addr, npages * mwr::get_page_size(),
+                      PROT_READ | PROT_WRITE) == 0;
+}
+
+void mem_protector::remember_unprotected(void* addr, size_t npages) {
+    m_recent[m_recent_idx] = page_run{ addr, npages };
+    m_recent_idx = (m_recent_idx + 1) % RECENT_RUNS;
+}
+
+bool mem_protector::recently_unprotected(void* page_addr) const {
+    vcml::u64 page = reinterpret_cast<vcml::u64>(page_addr);
+    for (const auto& run : m_recent) {
+        vcml::u64 start = reinterpret_cast<vcml::u64>(run.addr);
+        if (page >= start && page < start + run.npages * mwr::get_page_size())
+            return true;
+    }
+
+    return false;
+}
+
+void mem_protector::unprotect_all(std::vector<void*>& pages) {
+    for_each_page_run(pages, [&](void* addr, size_t npages) {
+        VCML_ERROR_ON(!unprotect_pages(addr, npages),
+                      "failed to unprotect page: %s", std::strerror(errno));
+    });
 }
 
 bool mem_protector::notify_page(void* access_addr) {
     void* page_addr = reinterpret_cast<void*>(
         reinterpret_cast<vcml::u64>(access_addr) & HOST_PAGE_MASK);
 
-    if (!m_protected_pages.count(page_addr)) // not a locked page
-        return false;
+    // cores are notified after the lock is released, since they might
+    // register or deregister pages themselves; this runs in the segfault
+    // handler, so nothing here may allocate memory
+    array<target_page_data, MAX_SHARED_PAGES> targets;
+    array<mem_protector_if*, MAX_SHARED_PAGES> owners;
+    size_t ntargets = 0;
+    size_t nowners = 0;
+
+    {
+        page_guard guard(*this);
+        host_page_data* page = m_protected_pages.find(page_addr);
+        if (!page || !page->locked) {
+            // another thread might have unprotected the page after our
+            // write faulted, in that case the write can simply be retried
+            return recently_unprotected(page_addr);
+        }
 
-    auto& page = m_protected_pages[page_addr];
-    for (const auto& tp : page.target_pages) {
-        tp.c->update_page(tp.page_addr);
+        // writers blocked by userfaultfd are woken up after notification
+        if (!unprotect_pages(page_addr, 1, false))
+            return false;
+
+        page->locked = false;
+        ntargets = page->target_pages.size();
+        for (size_t i = 0; i < ntargets; ++i)
+            targets[i] = page->target_pages[i];
     }
 
-    if (unprotect_page(reinterpret_cast<void*>(page_addr))) {
-        page.locked = false;
-        return true;
+    const vcml::u64 host_page = reinterpret_cast<vcml::u64>(page_addr);
+    const vcml::u64 host_page_end = host_page + mwr::get_page_size() - 1;
+    for (size_t i = 0; i < ntargets; ++i) {
+        const auto& tp = targets[i];
+        auto owners_end = owners.begin() + nowners;
+        if (std::find(owners.begin(), owners_end, tp.c) == owners_end)
+            owners[nowners++] = tp.c;
+
+        vcml::u64 host_start = reinterpret_cast<vcml::u64>(tp.host_address);
+        vcml::u64 host_end = host_start + tp.page_size - 1;
+        if (host_start >= host_page && host_end <= host_page_end) {
+            tp.c->update_page(tp.page_addr);
+            continue;
+        }
+
+        // only the part of the target page backed by this host page
+        vcml::u64 start = std::max(host_start, host_page) - host_start;
+        vcml::u64 end = std::min(host_end, host_page_end) - host_start;
+        tp.c->update_page_range(tp.page_addr, tp.page_addr + start,
+                                tp.page_addr + end);
     }
 
-    return false;
+    if (nowners > 0)
+        owners[0]->page_written(owners.data(), nowners);
+
+    if (m_backend == BACKEND_USERFAULTFD)
+        uffd_wake(page_addr, 1);
+
+    return true;
+}
+
+void mem_protector::index_target_page(const target_page_data& tp) {
+    auto& pages = m_target_pages[tp.c];
+    auto it = pages.find(tp.page_addr);
+    if (it != pages.end() && (it->second.host_address != tp.host_address ||
+                              it->second.page_size != tp.page_size)) {
+        // target page was remapped to different host memory
+        std::vector<void*> unprotect;
+        release_target_page(tp.c, tp.page_addr, it->second, unprotect);
+        unprotect_all(unprotect);
+    }
+
+    pages[tp.page_addr] = target_page_ref{ tp.host_address, tp.page_size };
+}
+
+void mem_protector::release_target_page(mem_protector_if* cpu,
+                                        vcml::u64 page_addr,
+                                        const target_page_ref& ref,
+                                        std::vector<void*>& unprotect) {
+    auto release_page = [&](void* addr) {
+        host_page_data* host_page = m_protected_pages.find(addr);
+        if (!host_page)
+            return;
+
+        host_page->target_pages.remove_if([&](const target_page_data& tp) {
+            return tp.c == cpu && tp.page_addr == page_addr;
+        });
+
+        if (!host_page->target_pages.empty())
+            return;
+
+        if (host_page->locked)
+            unprotect.push_back(addr);
+
+        m_protected_pages.erase(addr);
+    };
+
+    for_each_host_page(ref.host_address, ref.page_size, HOST_PAGE_MASK,
+                       release_page);
 }
 
 void mem_protector::deregister_page(mem_protector_if* cpu,
                                     vcml::u64 page_addr) {
-    for (auto host_page_it = m_protected_pages.begin();
-         host_page_it != m_protected_pages.end();) {
-        auto& target_pages = host_page_it->second.target_pages;
-
-        for (auto target_page_it = target_pages.begin();
-             target_page_it != target_pages.end();) {
-            if (target_page_it->page_addr == page_addr) {
-                target_page_it = target_pages.erase(target_page_it);
-                continue;
-            }
-            ++target_page_it;
-        }
-        if (target_pages.empty() && host_page_it->second.locked) {
-            VCML_ERROR_ON(
-                !unprotect_page(reinterpret_cast<void*>(host_page_it->first)),
-                "failed to unprotect page: %s", std::strerror(errno));
-            host_page_it = m_protected_pages.erase(host_page_it);
-            continue;
-        }
-        ++host_page_it;
-    }
+    page_guard guard(*this);
+    auto pages = m_target_pages.find(cpu);
+    if (pages == m_target_pages.end())
+        return;
+
+    auto it = pages->second.find(page_addr);
+    if (it == pages->second.end())
+        return;
+
+    std::vector<void*> unprotect;
+    release_target_page(cpu, page_addr, it->second, unprotect);
+    pages->second.erase(it);
+    unprotect_all(unprotect);
 }
 
 void mem_protector::deregister_pages(mem_protector_if* cpu, vcml::u64 start,
                                      vcml::u64 end) {
-    for (auto host_page_it = m_protected_pages.begin();
-         host_page_it != m_protected_pages.end();) {
-        auto& target_pages = host_page_it->second.target_pages;
-
-        for (auto target_page_it = target_pages.begin();
-             target_page_it != target_pages.end();) {
-            vcml::u64 target_page_start = target_page_it->page_addr;
-            vcml::u64 target_page_end = target_page_start +
-                                        target_page_it->page_size - 1;
-
-            if (target_page_start >= start && target_page_end <= end) {
-                target_page_it = target_pages.erase(target_page_it);
-                continue;
-            }
-            ++target_page_it;
-        }
-        if (target_pages.empty() && host_page_it->second.locked) {
-            VCML_ERROR_ON(
-                !unprotect_page(reinterpret_cast<void*>(host_page_it->first)),
-                "failed to unprotect page: %s", std::strerror(errno));
-            host_page_it = m_protected_pages.erase(host_page_it);
+    // only target pages that are fully covered by [start, end] are removed
+    page_guard guard(*this);
+    auto pages = m_target_pages.find(cpu);
+    if (pages == m_target_pages.end())
+        return;
+
+    std::vector<void*> unprotect;
+    auto it = pages->second.lower_bound(start);
+    while (it != pages->second.end() && it->first <= end) {
+        vcml::u64 target_page_end = it->first + it->second.page_size - 1;
+        if (target_page_end > end) {
+            ++it;
             continue;
         }
-        ++host_page_it;
+
+        release_target_page(cpu, it->first, it->second, unprotect);
+        it = pages->second.erase(it);
+    }
+
+    unprotect_all(unprotect);
+}
+
+void mem_protector::before_fork() {
+    // only the forking thread exists in the child, so the handler thread is
+    // stopped beforehand and restarted in both processes afterwards
+    if (m_backend == BACKEND_USERFAULTFD)
+        uffd_stop_thread();
+
+    lock();
+}
+
+void mem_protector::after_fork(bool child) {
+    if (!child && m_backend == BACKEND_USERFAULTFD)
+        m_uffd_thread = std::thread(&mem_protector::uffd_handler, this);
+
+    if (child && m_backend == BACKEND_USERFAULTFD) {
+        // the registrations of the parent's userfaultfd are not inherited,
+        // so the child opens its own one and protects the pages again
+        ::close(m_uffd);
+        ::close(m_uffd_stop);
+        m_uffd = -1;
+        m_uffd_stop = -1;
+        VCML_ERROR_ON(!uffd_open(), "cannot reopen userfaultfd after fork");
+
+        std::vector<void*> pages;
+        m_protected_pages.for_each([&](void* page, host_page_data& data) {
+            if (data.locked)
+                pages.push_back(page);
+        });
+
+        for_each_page_run(pages, [&](void* addr, size_t npages) {
+            protect_pages(addr, npages);
+        });
     }
+
+    unlock();
 }
 
 mem_protector& mem_protector::instance() {
@@ -0,0 +1,74 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/ocx_library.h"
+
+#include <dlfcn.h>
+#include <mutex>
+
+namespace avp64 {
+namespace psp {
+
+static std::mutex g_ocx_mtx;
+static weak_ptr<ocx_library> g_ocx_library;
+
+shared_ptr<ocx_library> ocx_library::get() {
+    std::lock_guard<std::mutex> guard(g_ocx_mtx);
+    shared_ptr<ocx_library> lib = g_ocx_library.lock();
+    if (!lib) {
+        lib.reset(new ocx_library("libocx-qemu-arm.so"));
+        g_ocx_library = lib;
+    }
+
+    return lib;
+}
+
+long ocx_library::users() {
+    std::lock_guard<std::mutex> guard(g_ocx_mtx);
+    return g_ocx_library.use_count();
+}
+
+ocx_library::ocx_library(const char* path):
+    m_handle(nullptr), m_create_instance(nullptr), m_delete_instance(nullptr) {
+    m_handle = dlopen(path, RTLD_LAZY);
+    VCML_ERROR_ON(!m_handle, "Could not load %s: %s", path, dlerror());
+
+    m_create_instance = lookup<create_instance_t>(
+        "_ZN3ocx15create_instanceEmRNS_3envEPKc");
+    m_delete_instance = lookup<delete_instance_t>(
+        "_ZN3ocx15delete_instanceEPNS_4coreE");
+}
+
+ocx_library::~ocx_library() {
+    m_create_instance = nullptr;
+    m_delete_instance = nullptr;
+    dlclose(m_handle);
+    m_handle = nullptr;
+}
+
+ocx::core* ocx_library::create_instance(ocx::u64 version, ocx::env& env,
+                                        const char* variant) const {
+    return m_create_instance(version, env, variant);
+}
+
+void ocx_library::delete_instance(ocx::core* core) const {
+    m_delete_instance(core);
+}
+
+template <typename T>
+T ocx_library::lookup(const char* name) {
+    dlerror();
+    T func = (T)dlsym(m_handle, name);
+    const char* dlsym_err = dlerror();
+    VCML_ERROR_ON(dlsym_err, "Could not load symbol %s: %s", name, dlsym_err);
+    return func;
+}
+
+} // namespace psp
+} // namespace avp64
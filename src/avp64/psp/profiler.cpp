@@ -0,0 +1,112 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/profiler.h"
+
+#include <algorithm>
+
+namespace avp64 {
+namespace psp {
+
+// every staged sample is stored as [weight, depth, frames...]
+constexpr size_t SAMPLE_HEADER = 2;
+
+profiler::profiler(size_t capacity):
+    m_buffer(std::max(capacity, SAMPLE_HEADER + MAX_DEPTH)),
+    m_used(0),
+    m_num_samples(0),
+    m_total_weight(0),
+    m_flat(),
+    m_stacks() {
+}
+
+void profiler::sample(vcml::u64 weight, const vcml::u64* frames,
+                      size_t depth) {
+    if (depth == 0)
+        return;
+
+    depth = std::min(depth, MAX_DEPTH);
+    if (m_used + SAMPLE_HEADER + depth > m_buffer.size())
+        fold();
+
+    m_buffer[m_used++] = weight;
+    m_buffer[m_used++] = depth;
+    std::copy(frames, frames + depth, m_buffer.begin() + m_used);
+    m_used += depth;
+
+    m_num_samples++;
+    m_total_weight += weight;
+}
+
+void profiler::reset() {
+    m_used = 0;
+    m_num_samples = 0;
+    m_total_weight = 0;
+    m_flat.clear();
+    m_stacks.clear();
+}
+
+void profiler::fold() {
+    for (size_t pos = 0; pos < m_used;) {
+        vcml::u64 weight = m_buffer[pos];
+        size_t depth = m_buffer[pos + 1];
+        auto first = m_buffer.begin() + pos + SAMPLE_HEADER;
+
+        m_flat[*first] += weight;
+        m_stacks[vector<vcml::u64>(first, first + depth)] += weight;
+
+        pos += SAMPLE_HEADER + depth;
+    }
+
+    m_used = 0;
+}
+
+void profiler::write_flat(std::ostream& os, const symbolizer& sym) {
+    fold();
+
+    std::unordered_map<string, vcml::u64> self;
+    for (const auto& [pc, weight] : m_flat)
+        self[sym(pc)] += weight;
+
+    vector<pair<string, vcml::u64>> sorted(self.begin(), self.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+
+    double total = static_cast<double>(std::max<vcml::u64>(m_total_weight, 1));
+    os << "# samples: " << m_num_samples << ", weight: " << m_total_weight
+       << "\n";
+    for (const auto& [name, weight] : sorted) {
+        os << mwr::mkstr("%6.2f%% %12llu  ", weight * 100.0 / total,
+                         static_cast<unsigned long long>(weight))
+           << name << "\n";
+    }
+}
+
+void profiler::write_folded(std::ostream& os, const symbolizer& sym) {
+    fold();
+
+    std::map<string, vcml::u64> folded;
+    for (const auto& [frames, weight] : m_stacks) {
+        string stack;
+        for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+            if (!stack.empty())
+                stack += ";";
+            stack += sym(*it);
+        }
+
+        folded[stack] += weight;
+    }
+
+    for (const auto& [stack, weight] : folded)
+        os << stack << " " << weight << "\n";
+}
+
+} // namespace psp
+} // namespace avp64
@@ -0,0 +1,62 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/quantum.h"
+
+#include <algorithm>
+
+namespace avp64 {
+namespace psp {
+
+quantum_controller::quantum_controller():
+    m_min(0),
+    m_max(0),
+    m_quantum(0),
+    m_events(0),
+    m_quiet(0),
+    m_histogram() {
+}
+
+void quantum_controller::configure(vcml::u64 min, vcml::u64 max) {
+    VCML_ERROR_ON(max > 0 && min > max, "invalid quantum bounds");
+    m_min = std::max<vcml::u64>(min, 1);
+    m_max = max;
+    reset();
+}
+
+void quantum_controller::reset() {
+    // start small, boot code quickly proves whether it is device bound
+    m_quantum = m_min;
+    m_events = 0;
+    m_quiet = 0;
+    m_histogram.fill(0);
+}
+
+void quantum_controller::update(vcml::u64 cycles) {
+    m_histogram[bucket(cycles)]++;
+
+    if (m_events >= SHRINK_EVENTS) {
+        m_quantum = std::max(m_quantum / 2, m_min);
+        m_quiet = 0;
+    } else if (m_events > 0) {
+        m_quiet = 0;
+    } else if (++m_quiet >= GROW_QUANTA) {
+        m_quantum = std::min(m_quantum * 2, m_max);
+        m_quiet = 0;
+    }
+
+    m_events = 0;
+}
+
+size_t quantum_controller::bucket(vcml::u64 cycles) {
+    return cycles ? 63 - __builtin_clzll(cycles) : 0;
+}
+
+} // namespace psp
+} // namespace avp64
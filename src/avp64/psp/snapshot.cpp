@@ -0,0 +1,251 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace avp64 {
+namespace psp {
+
+constexpr size_t RLE_MIN_RUN = 3;
+constexpr size_t RLE_MAX_RUN = 130;
+constexpr size_t RLE_MAX_LITERALS = 128;
+
+static bool is_zero(const vcml::u8* src, size_t len) {
+    static const vcml::u8 zero[snapshot_section::PAGE_SIZE] = {};
+    return std::memcmp(src, zero, len) == 0;
+}
+
+static size_t run_length(const vcml::u8* src, size_t len) {
+    size_t n = 1;
+    while (n < len && n < RLE_MAX_RUN && src[n] == src[0])
+        n++;
+    return n;
+}
+
+size_t snapshot_rle_encode(const vcml::u8* src, size_t len, vcml::u8* dest,
+                           size_t limit) {
+    size_t out = 0;
+    size_t pos = 0;
+    while (pos < len) {
+        size_t run = run_length(src + pos, len - pos);
+        if (run >= RLE_MIN_RUN) {
+            if (out + 2 > limit)
+                return 0;
+            dest[out++] = static_cast<vcml::u8>(run + 125);
+            dest[out++] = src[pos];
+            pos += run;
+            continue;
+        }
+
+        // collect literals up to the next run worth encoding
+        size_t start = pos;
+        while (pos < len && pos - start < RLE_MAX_LITERALS &&
+               run_length(src + pos, len - pos) < RLE_MIN_RUN)
+            pos++;
+
+        size_t n = pos - start;
+        if (out + n + 1 > limit)
+            return 0;
+
+        dest[out++] = static_cast<vcml::u8>(n - 1);
+        std::memcpy(dest + out, src + start, n);
+        out += n;
+    }
+
+    return out;
+}
+
+bool snapshot_rle_decode(const vcml::u8* src, size_t len, vcml::u8* dest,
+                         size_t size) {
+    size_t out = 0;
+    size_t pos = 0;
+    while (pos < len) {
+        vcml::u8 ctrl = src[pos++];
+        if (ctrl < RLE_MAX_LITERALS) {
+            size_t n = ctrl + 1;
+            if (pos + n > len || out + n > size)
+                return false;
+            std::memcpy(dest + out, src + pos, n);
+            pos += n;
+            out += n;
+        } else {
+            size_t n = ctrl - 125;
+            if (pos >= len || out + n > size)
+                return false;
+            std::memset(dest + out, src[pos++], n);
+            out += n;
+        }
+    }
+
+    return out == size;
+}
+
+snapshot_section::snapshot_section(): m_data(), m_pos(0), m_zero_pages(0) {
+    // nothing to do
+}
+
+void snapshot_section::write(const void* src, size_t len) {
+    const auto* bytes = static_cast<const vcml::u8*>(src);
+    m_data.insert(m_data.end(), bytes, bytes + len);
+}
+
+void snapshot_section::read(void* dest, size_t len) {
+    VCML_ERROR_ON(m_pos + len > m_data.size(), "snapshot section truncated");
+    std::memcpy(dest, m_data.data() + m_pos, len);
+    m_pos += len;
+}
+
+void snapshot_section::put_str(const string& str) {
+    put<vcml::u64>(str.size());
+    write(str.data(), str.size());
+}
+
+string snapshot_section::get_str() {
+    vcml::u64 len = get<vcml::u64>();
+    VCML_ERROR_ON(len > m_data.size() - m_pos, "snapshot section truncated");
+    string str(len, '\0');
+    read(&str[0], len);
+    return str;
+}
+
+void snapshot_section::write_pages(const vcml::u8* src, size_t len) {
+    vcml::u8 buf[PAGE_SIZE];
+    for (size_t off = 0; off < len; off += PAGE_SIZE) {
+        const vcml::u8* page = src + off;
+        size_t size = std::min(PAGE_SIZE, len - off);
+
+        if (is_zero(page, size)) {
+            put<vcml::u8>(SNAPSHOT_PAGE_ZERO);
+            m_zero_pages++;
+            continue;
+        }
+
+        size_t n = snapshot_rle_encode(page, size, buf, size - 2);
+        if (n > 0) {
+            put<vcml::u8>(SNAPSHOT_PAGE_RLE);
+            put<vcml::u16>(static_cast<vcml::u16>(n));
+            write(buf, n);
+        } else {
+            put<vcml::u8>(SNAPSHOT_PAGE_RAW);
+            write(page, size);
+        }
+    }
+}
+
+void snapshot_section::read_pages(vcml::u8* dest, size_t len) {
+    for (size_t off = 0; off < len; off += PAGE_SIZE) {
+        vcml::u8* page = dest + off;
+        size_t size = std::min(PAGE_SIZE, len - off);
+
+        switch (get<vcml::u8>()) {
+        case SNAPSHOT_PAGE_ZERO:
+            std::memset(page, 0, size);
+            break;
+
+        case SNAPSHOT_PAGE_RAW:
+            read(page, size);
+            break;
+
+        case SNAPSHOT_PAGE_RLE: {
+            size_t n = get<vcml::u16>();
+            VCML_ERROR_ON(m_pos + n > m_data.size(),
+                          "snapshot section truncated");
+            VCML_ERROR_ON(!snapshot_rle_decode(m_data.data() + m_pos, n, page,
+                                               size),
+                          "corrupted snapshot page at offset %zu", off);
+            m_pos += n;
+            break;
+        }
+
+        default:
+            VCML_ERROR("invalid snapshot page encoding at offset %zu", off);
+        }
+    }
+}
+
+snapshot::snapshot(): m_sections() {
+    // nothing to do
+}
+
+bool snapshot::has_section(const string& name) const {
+    return m_sections.count(name) > 0;
+}
+
+snapshot_section& snapshot::create(const string& name) {
+    snapshot_section& sec = m_sections[name];
+    sec = snapshot_section();
+    return sec;
+}
+
+snapshot_section& snapshot::section(const string& name) {
+    auto it = m_sections.find(name);
+    VCML_ERROR_ON(it == m_sections.end(), "snapshot has no section '%s'",
+                  name.c_str());
+    it->second.rewind();
+    return it->second;
+}
+
+void snapshot::save(const string& path) const {
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    VCML_ERROR_ON(!os, "cannot open snapshot file '%s'", path.c_str());
+
+    snapshot_header header{};
+    std::copy(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + 8, header.magic);
+    header.version = SNAPSHOT_VERSION;
+    header.num_sections = m_sections.size();
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto& [name, sec] : m_sections) {
+        vcml::u32 namelen = name.size();
+        vcml::u64 size = sec.size();
+        os.write(reinterpret_cast<const char*>(&namelen), sizeof(namelen));
+        os.write(name.data(), namelen);
+        os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        os.write(reinterpret_cast<const char*>(sec.data().data()), size);
+    }
+
+    VCML_ERROR_ON(!os, "error writing snapshot file '%s'", path.c_str());
+}
+
+void snapshot::load(const string& path) {
+    std::ifstream is(path, std::ios::binary);
+    VCML_ERROR_ON(!is, "cannot open snapshot file '%s'", path.c_str());
+
+    snapshot_header header{};
+    is.read(reinterpret_cast<char*>(&header), sizeof(header));
+    VCML_ERROR_ON(!is || !std::equal(header.magic, header.magic + 8,
+                                     SNAPSHOT_MAGIC),
+                  "'%s' is not a snapshot file", path.c_str());
+    VCML_ERROR_ON(header.version != SNAPSHOT_VERSION,
+                  "unsupported snapshot file version %u", header.version);
+
+    m_sections.clear();
+    for (vcml::u64 i = 0; i < header.num_sections; ++i) {
+        vcml::u32 namelen = 0;
+        is.read(reinterpret_cast<char*>(&namelen), sizeof(namelen));
+        string name(is ? namelen : 0, '\0');
+        is.read(name.data(), name.size());
+
+        vcml::u64 size = 0;
+        is.read(reinterpret_cast<char*>(&size), sizeof(size));
+        VCML_ERROR_ON(!is, "snapshot file '%s' is truncated", path.c_str());
+
+        snapshot_section& sec = create(name);
+        sec.data().resize(size);
+        is.read(reinterpret_cast<char*>(sec.data().data()), size);
+        VCML_ERROR_ON(!is, "snapshot file '%s' is truncated", path.c_str());
+    }
+}
+
+} // namespace psp
+} // namespace avp64
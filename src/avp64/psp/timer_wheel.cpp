@@ -0,0 +1,139 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/timer_wheel.h"
+#include "avp64/psp/systemc.h"
+
+#include <algorithm>
+
+namespace avp64 {
+namespace psp {
+
+timer_wheel::timer_wheel(size_t ntimers):
+    m_deadlines(ntimers, NONE), m_next(NONE) {
+}
+
+size_t timer_wheel::add_timers(size_t n) {
+    size_t first = m_deadlines.size();
+    m_deadlines.resize(first + n, NONE);
+    return first;
+}
+
+void timer_wheel::update_next() {
+    m_next = NONE;
+    for (vcml::u64 deadline : m_deadlines)
+        m_next = std::min(m_next, deadline);
+}
+
+bool timer_wheel::schedule(size_t timer, vcml::u64 deadline_ps) {
+    vcml::u64 prev = m_next;
+    vcml::u64& deadline = m_deadlines.at(timer);
+    bool was_next = deadline == m_next;
+    deadline = deadline_ps;
+
+    // only moving the earliest deadline later requires a full scan
+    if (deadline_ps < m_next)
+        m_next = deadline_ps;
+    else if (was_next)
+        update_next();
+
+    return m_next != prev;
+}
+
+bool timer_wheel::cancel(size_t timer) {
+    return schedule(timer, NONE);
+}
+
+size_t timer_wheel::expire(vcml::u64 now_ps,
+                           const std::function<void(size_t)>& func) {
+    if (m_next > now_ps)
+        return 0;
+
+    vector<size_t> due;
+    for (size_t timer = 0; timer < m_deadlines.size(); ++timer) {
+        if (m_deadlines[timer] <= now_ps) {
+            m_deadlines[timer] = NONE;
+            due.push_back(timer);
+        }
+    }
+
+    update_next();
+    for (size_t timer : due)
+        func(timer);
+
+    return due.size();
+}
+
+timer_dispatcher::timer_dispatcher():
+    m_wheel(),
+    m_clients(),
+    m_owner(),
+    m_event("timer_event"),
+    m_scheduled(timer_wheel::NONE),
+    m_num_dispatched(0),
+    m_num_rescheduled(0) {
+}
+
+size_t timer_dispatcher::add_client(size_t ntimers, const handler& func) {
+    size_t first = m_wheel.add_timers(ntimers);
+    m_owner.resize(m_wheel.size(), m_clients.size());
+    m_clients.push_back({ first, func });
+    return first;
+}
+
+void timer_dispatcher::schedule(size_t timer, vcml::u64 deadline_ps) {
+    if (m_wheel.schedule(timer, deadline_ps))
+        reschedule();
+}
+
+void timer_dispatcher::cancel(size_t timer) {
+    if (m_wheel.cancel(timer))
+        reschedule();
+}
+
+void timer_dispatcher::start(const char* name) {
+    sc_core::sc_spawn_options opts;
+    opts.spawn_method();
+    opts.set_sensitivity(&m_event);
+    opts.dont_initialize();
+
+    sc_core::sc_spawn(sc_bind(&timer_dispatcher::dispatch, this),
+                      sc_core::sc_gen_unique_name(name), &opts);
+}
+
+void timer_dispatcher::dispatch() {
+    m_scheduled = timer_wheel::NONE;
+
+    vcml::u64 now = vcml::time_to_ps(sc_core::sc_time_stamp());
+    m_num_dispatched += m_wheel.expire(now, [this](size_t timer) {
+        const client& c = m_clients[m_owner[timer]];
+        c.func(timer - c.first);
+    });
+
+    reschedule();
+}
+
+void timer_dispatcher::reschedule() {
+    vcml::u64 next = m_wheel.next();
+    if (next == m_scheduled)
+        return;
+
+    m_event.cancel();
+    m_scheduled = next;
+    if (next == timer_wheel::NONE)
+        return;
+
+    m_num_rescheduled++;
+    sc_core::sc_time now = sc_core::sc_time_stamp();
+    sc_core::sc_time when = time_from_ps(next);
+    m_event.notify(when > now ? when - now : sc_core::SC_ZERO_TIME);
+}
+
+} // namespace psp
+} // namespace avp64
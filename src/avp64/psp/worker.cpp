@@ -0,0 +1,137 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/worker.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace avp64 {
+namespace psp {
+
+worker::worker(int host_cpu):
+    m_mtx(),
+    m_cv_worker(),
+    m_cv_caller(),
+    m_job(),
+    m_call(nullptr),
+    m_busy(false),
+    m_stop(false),
+    m_job_error(),
+    m_call_error(),
+    m_num_jobs(0),
+    m_num_calls(0),
+    m_thread() {
+    m_thread = std::thread(&worker::run, this, host_cpu);
+}
+
+worker::~worker() {
+    {
+        std::lock_guard<std::mutex> guard(m_mtx);
+        m_stop = true;
+    }
+
+    m_cv_worker.notify_all();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void worker::run(int host_cpu) {
+    if (host_cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(host_cpu, &set);
+        // pinning is only a hint, running unpinned is still correct
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    std::unique_lock<std::mutex> lock(m_mtx);
+    while (true) {
+        m_cv_worker.wait(lock, [this]() { return m_stop || m_job; });
+        if (m_stop)
+            return;
+
+        function job = std::move(m_job);
+        m_job = nullptr;
+        lock.unlock();
+
+        std::exception_ptr error;
+        try {
+            job();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        m_job_error = error;
+        m_busy = false;
+        m_cv_caller.notify_all();
+    }
+}
+
+void worker::start(function job) {
+    std::lock_guard<std::mutex> guard(m_mtx);
+    VCML_ERROR_ON(m_busy, "worker is still busy");
+    m_job = std::move(job);
+    m_busy = true;
+    m_num_jobs++;
+    m_cv_worker.notify_all();
+}
+
+void worker::finish() {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    while (true) {
+        m_cv_caller.wait(lock, [this]() { return !m_busy || m_call; });
+        if (!m_call)
+            break;
+
+        const function* func = m_call;
+        lock.unlock();
+
+        std::exception_ptr error;
+        try {
+            (*func)();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        m_call_error = error;
+        m_call = nullptr;
+        m_cv_worker.notify_all();
+    }
+
+    if (m_job_error) {
+        std::exception_ptr error = m_job_error;
+        m_job_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void worker::call(const function& func) {
+    if (!on_worker()) {
+        func();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mtx);
+    m_call = &func;
+    m_num_calls++;
+    m_cv_caller.notify_all();
+    m_cv_worker.wait(lock, [this]() { return m_call == nullptr; });
+
+    if (m_call_error) {
+        std::exception_ptr error = m_call_error;
+        m_call_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace psp
+} // namespace avp64
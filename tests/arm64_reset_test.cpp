@@ -10,10 +10,14 @@
 #include <gtest/gtest.h>
 #include "avp64/psp/core.h"
 
+#include <memory>
+#include <vector>
+
 class arm64_core_test : public avp64::psp::core
 {
 public:
-    arm64_core_test(): avp64::psp::core("test_core", 0, 1){};
+    explicit arm64_core_test(const sc_core::sc_module_name& nm):
+        avp64::psp::core(nm, 0, 1){};
     bool read_reg(id_t regno, void* buf, size_t len) {
         return read_reg_dbg(regno, buf, len);
     }
@@ -22,70 +26,115 @@ public:
     }
 };
 
+// one core per value of reset_in_place, all of them run in the same
+// simulation because SystemC only elaborates once per process
+struct reset_setup {
+    arm64_core_test cpu;
+    vcml::generic::memory imem;
+    vcml::generic::memory dmem;
+
+    reset_setup(const std::string& name, bool in_place):
+        cpu((name + "_core").c_str()),
+        imem((name + "_imem").c_str(), 0x1000),
+        dmem((name + "_dmem").c_str(), 0x10000) {
+        cpu.reset_in_place = in_place;
+    }
+};
+
 TEST(avp64, reset) {
-    arm64_core_test test_cpu;
+    std::vector<std::unique_ptr<reset_setup>> setups;
+    setups.push_back(std::make_unique<reset_setup>("reopen", false));
+    setups.push_back(std::make_unique<reset_setup>("in_place", true));
 
     mwr::hz_t defclk = 1 * mwr::kHz;
     vcml::generic::clock clock("clk", defclk);
     vcml::generic::reset reset("rst");
 
-    vcml::generic::memory imem("imem", 0x1000);
-    vcml::generic::memory dmem("dmem", 0x10000);
     vcml::range r(0x0, 0xf);
-
-    clock.clk.bind(test_cpu.clk);
-    clock.clk.bind(imem.clk);
-    clock.clk.bind(dmem.clk);
-    reset.rst.bind(test_cpu.rst);
-    reset.rst.bind(imem.rst);
-    reset.rst.bind(dmem.rst);
-    // Sockets are bound, but only DATA is used for MMIO
-    test_cpu.insn.bind(imem.in);
-    test_cpu.data.bind(dmem.in);
-    for (size_t i = 0; i < avp64::psp::core::ARM_TIMER_COUNT; ++i)
-        test_cpu.timer_irq_out[i].stub();
-
-    vcml::u64 pc, x0, x1;
-    sc_core::sc_time quantum(1.0, sc_core::SC_SEC);
-    tlm::tlm_global_quantum::instance().set(quantum);
-
     vcml::u32 insn_mmio[4] = { 0xd2995fc0, // 0x0: mov x0, #0xcafe
                                0xf9400001, // 0x4: ldr x1, [x0]
                                0x14000000, // 0x8: b 0x8
                                0x00000000 };
 
-    vcml::tlm_sbi info = vcml::SBI_NONE;
-    imem.write(r, &insn_mmio, info);
+    for (auto& s : setups) {
+        clock.clk.bind(s->cpu.clk);
+        clock.clk.bind(s->imem.clk);
+        clock.clk.bind(s->dmem.clk);
+        reset.rst.bind(s->cpu.rst);
+        reset.rst.bind(s->imem.rst);
+        reset.rst.bind(s->dmem.rst);
+        // Sockets are bound, but only DATA is used for MMIO
+        s->cpu.insn.bind(s->imem.in);
+        s->cpu.data.bind(s->dmem.in);
+        for (size_t i = 0; i < avp64::psp::core::ARM_TIMER_COUNT; ++i)
+            s->cpu.timer_irq_out[i].stub();
 
-    pc = 0;
-    EXPECT_TRUE(test_cpu.write_reg(32, &pc, 8));
-    EXPECT_TRUE(test_cpu.write_reg(0, &pc, 8));
-    EXPECT_TRUE(test_cpu.write_reg(1, &pc, 8));
-    EXPECT_TRUE(test_cpu.read_reg(32, &pc, 8));
-    EXPECT_TRUE(test_cpu.read_reg(0, &x0, 8));
-    EXPECT_TRUE(test_cpu.read_reg(1, &x1, 8));
-    EXPECT_EQ(pc, 0x0);
-    EXPECT_EQ(x0, 0x0);
-    EXPECT_EQ(x1, 0x0);
+        vcml::tlm_sbi info = vcml::SBI_NONE;
+        s->imem.write(r, &insn_mmio, info);
+    }
+
+    vcml::u64 pc, x0, x1;
+    sc_core::sc_time quantum(1.0, sc_core::SC_SEC);
+    tlm::tlm_global_quantum::instance().set(quantum);
+
+    for (auto& s : setups) {
+        SCOPED_TRACE(s->cpu.name());
+        pc = 0;
+        EXPECT_TRUE(s->cpu.write_reg(32, &pc, 8));
+        EXPECT_TRUE(s->cpu.write_reg(0, &pc, 8));
+        EXPECT_TRUE(s->cpu.write_reg(1, &pc, 8));
+        EXPECT_TRUE(s->cpu.read_reg(32, &pc, 8));
+        EXPECT_TRUE(s->cpu.read_reg(0, &x0, 8));
+        EXPECT_TRUE(s->cpu.read_reg(1, &x1, 8));
+        EXPECT_EQ(pc, 0x0);
+        EXPECT_EQ(x0, 0x0);
+        EXPECT_EQ(x1, 0x0);
+    }
 
     sc_core::sc_start(quantum);
 
-    EXPECT_TRUE(test_cpu.read_reg(32, &pc, 8));
-    EXPECT_TRUE(test_cpu.read_reg(0, &x0, 8));
-    EXPECT_TRUE(test_cpu.read_reg(1, &x1, 8));
-    EXPECT_EQ(test_cpu.cycle_count(), quantum.to_seconds() * defclk);
-    EXPECT_EQ(pc, 0x8);
-    EXPECT_EQ(x0, 0xcafe);
-    EXPECT_EQ(x1, 0x0);
+    std::vector<vcml::u64> quanta;
+    for (auto& s : setups) {
+        SCOPED_TRACE(s->cpu.name());
+        EXPECT_TRUE(s->cpu.read_reg(32, &pc, 8));
+        EXPECT_TRUE(s->cpu.read_reg(0, &x0, 8));
+        EXPECT_TRUE(s->cpu.read_reg(1, &x1, 8));
+        EXPECT_EQ(s->cpu.cycle_count(), quantum.to_seconds() * defclk);
+        EXPECT_EQ(pc, 0x8);
+        EXPECT_EQ(x0, 0xcafe);
+        EXPECT_EQ(x1, 0x0);
+        quanta.push_back(s->cpu.stats().quanta);
+        EXPECT_GT(quanta.back(), 0);
+    }
 
-    // Reset the CPU
+    // Reset the CPUs
     reset.rst.pulse();
 
-    EXPECT_TRUE(test_cpu.read_reg(32, &pc, 8));
-    EXPECT_TRUE(test_cpu.read_reg(0, &x0, 8));
-    EXPECT_TRUE(test_cpu.read_reg(1, &x1, 8));
-    EXPECT_EQ(pc, 0x0);
-    EXPECT_EQ(x0, 0x0);
-    EXPECT_EQ(x1, 0x0);
-    EXPECT_EQ(test_cpu.cycle_count(), 0);
+    for (size_t i = 0; i < setups.size(); ++i) {
+        auto& s = setups[i];
+        SCOPED_TRACE(s->cpu.name());
+        EXPECT_TRUE(s->cpu.read_reg(32, &pc, 8));
+        EXPECT_TRUE(s->cpu.read_reg(0, &x0, 8));
+        EXPECT_TRUE(s->cpu.read_reg(1, &x1, 8));
+        EXPECT_EQ(pc, 0x0);
+        EXPECT_EQ(x0, 0x0);
+        EXPECT_EQ(x1, 0x0);
+        EXPECT_EQ(s->cpu.cycle_count(), 0);
+
+        // counters accumulate across resets
+        EXPECT_EQ(s->cpu.stats().quanta, quanta[i]);
+    }
+
+    // translations were dropped, the same code executes again
+    sc_core::sc_start(quantum);
+
+    for (size_t i = 0; i < setups.size(); ++i) {
+        auto& s = setups[i];
+        SCOPED_TRACE(s->cpu.name());
+        EXPECT_TRUE(s->cpu.read_reg(32, &pc, 8));
+        EXPECT_TRUE(s->cpu.read_reg(0, &x0, 8));
+        EXPECT_EQ(pc, 0x8);
+        EXPECT_EQ(x0, 0xcafe);
+        EXPECT_GT(s->cpu.stats().quanta, quanta[i]);
+    }
 }
@@ -0,0 +1,84 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include "avp64/psp/core.h"
+
+class arm64_smc_test : public avp64::psp::core
+{
+public:
+    arm64_smc_test(): avp64::psp::core("test_core", 0, 1) {}
+    bool read_reg(id_t regno, void* buf, size_t len) {
+        return read_reg_dbg(regno, buf, len);
+    }
+    bool write_reg(id_t regno, const void* buf, size_t len) {
+        return write_reg_dbg(regno, buf, len);
+    }
+};
+
+TEST(avp64, self_modifying_code) {
+    arm64_smc_test test_cpu;
+
+    mwr::hz_t defclk = 1 * mwr::kHz;
+    vcml::generic::clock clock("clk", defclk);
+    vcml::generic::reset reset("rst");
+
+    // code and data share one memory, so that stores hit translated code
+    vcml::generic::memory mem("mem", 0x1000);
+    vcml::generic::bus bus("bus");
+
+    clock.clk.bind(test_cpu.clk);
+    clock.clk.bind(mem.clk);
+    clock.clk.bind(bus.clk);
+    reset.rst.bind(test_cpu.rst);
+    reset.rst.bind(mem.rst);
+    reset.rst.bind(bus.rst);
+    bus.bind(test_cpu.insn);
+    bus.bind(test_cpu.data);
+    bus.bind(mem.in, vcml::range(0x0, 0xfff));
+    for (size_t i = 0; i < avp64::psp::core::ARM_TIMER_COUNT; ++i)
+        test_cpu.timer_irq_out[i].stub();
+
+    // the whole program runs within a single quantum
+    sc_core::sc_time quantum(1.0, sc_core::SC_SEC);
+    tlm::tlm_global_quantum::instance().set(quantum);
+
+    vcml::u32 insn_smc[17] = {
+        0xd2800403, // 0x00: mov x3, #0x20
+        0x180001e2, // 0x04: ldr w2, 0x40
+        0x94000006, // 0x08: bl 0x20
+        0xaa0103e4, // 0x0c: mov x4, x1
+        0xb9000062, // 0x10: str w2, [x3]
+        0x94000003, // 0x14: bl 0x20
+        0x14000000, // 0x18: b 0x18
+        0xd503201f, // 0x1c: nop
+        0xd2800021, // 0x20: mov x1, #1
+        0xd65f03c0, // 0x24: ret
+        0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+        0xd2800041, // 0x40: mov x1, #2
+    };
+
+    vcml::tlm_sbi info = vcml::SBI_NONE;
+    mem.write(vcml::range(0x0, sizeof(insn_smc) - 1), &insn_smc, info);
+
+    vcml::u64 zero = 0;
+    EXPECT_TRUE(test_cpu.write_reg(32, &zero, 8));
+
+    sc_core::sc_start(quantum);
+
+    // the second call must execute the patched instruction
+    vcml::u64 pc, x1, x4;
+    EXPECT_TRUE(test_cpu.read_reg(32, &pc, 8));
+    EXPECT_TRUE(test_cpu.read_reg(1, &x1, 8));
+    EXPECT_TRUE(test_cpu.read_reg(4, &x4, 8));
+    EXPECT_EQ(pc, 0x18);
+    EXPECT_EQ(x4, 1);
+    EXPECT_EQ(x1, 2);
+}
@@ -0,0 +1,83 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/bb_trace.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+
+using avp64::psp::bb_trace_reader;
+using avp64::psp::bb_trace_writer;
+
+TEST(avp64, bb_trace) {
+    const std::string path = "bb_trace_test.bin";
+    constexpr size_t nrecords = 200000;
+
+    auto vaddr_of = [](size_t i) -> vcml::u64 {
+        // mostly small forward and backward jumps, some far away
+        if (i % 1000 == 0)
+            return 0xffff800010000000ull + i;
+        return 0x400000 + (i % 64) * 0x40 - (i % 3) * 0x10;
+    };
+
+    {
+        // a small ring forces the producer to wait for the writer
+        bb_trace_writer writer(path, 3, 256);
+        for (size_t i = 0; i < nrecords; ++i)
+            writer.record(vaddr_of(i), i * 1000);
+        writer.close();
+
+        EXPECT_EQ(writer.num_records(), nrecords);
+        EXPECT_LT(writer.file_size(), nrecords * 6);
+    }
+
+    bb_trace_reader reader(path);
+    EXPECT_EQ(reader.core_id(), 3);
+
+    size_t n = 0;
+    vcml::u64 vaddr, time_ps;
+    while (reader.next(vaddr, time_ps)) {
+        ASSERT_EQ(vaddr, vaddr_of(n));
+        ASSERT_EQ(time_ps, n * 1000);
+        n++;
+    }
+
+    EXPECT_EQ(n, nrecords);
+    std::remove(path.c_str());
+}
+
+TEST(avp64, bb_trace_suspend) {
+    const std::string path = "bb_trace_suspend_test.bin";
+
+    {
+        bb_trace_writer writer(path, 0, 256);
+        for (size_t i = 0; i < 1000; ++i)
+            writer.record(0x1000 + i * 4, i);
+
+        // suspending writes out everything recorded so far, like before fork
+        writer.suspend();
+        writer.resume();
+
+        for (size_t i = 1000; i < 2000; ++i)
+            writer.record(0x1000 + i * 4, i);
+        writer.close();
+    }
+
+    bb_trace_reader reader(path);
+    size_t n = 0;
+    vcml::u64 vaddr, time_ps;
+    while (reader.next(vaddr, time_ps)) {
+        ASSERT_EQ(vaddr, 0x1000 + n * 4);
+        ASSERT_EQ(time_ps, n);
+        n++;
+    }
+
+    EXPECT_EQ(n, 2000);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,82 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include "avp64/psp/core.h"
+
+#include <cstdio>
+
+class bbtrace_bench_core : public avp64::psp::core
+{
+public:
+    bbtrace_bench_core(): avp64::psp::core("bench_core", 0, 1) {}
+    bool write_reg(id_t regno, const void* buf, size_t len) {
+        return write_reg_dbg(regno, buf, len);
+    }
+};
+
+static double run_mips(bbtrace_bench_core& cpu, const sc_core::sc_time& t) {
+    vcml::u64 insns = cpu.cycle_count();
+    double start = mwr::timestamp();
+    sc_core::sc_start(t);
+    double elapsed = mwr::timestamp() - start;
+    return (cpu.cycle_count() - insns) / elapsed / 1e6;
+}
+
+TEST(avp64, bbtrace_bench) {
+    bbtrace_bench_core test_cpu;
+
+    mwr::hz_t defclk = 100 * mwr::MHz;
+    vcml::generic::clock clock("clk", defclk);
+    vcml::generic::reset reset("rst");
+    vcml::generic::memory imem("imem", 0x1000);
+    vcml::generic::memory dmem("dmem", 0x1000);
+    vcml::range r(0x0, 0x7);
+
+    clock.clk.bind(test_cpu.clk);
+    clock.clk.bind(imem.clk);
+    clock.clk.bind(dmem.clk);
+    reset.rst.bind(test_cpu.rst);
+    reset.rst.bind(imem.rst);
+    reset.rst.bind(dmem.rst);
+    test_cpu.insn.bind(imem.in);
+    test_cpu.data.bind(dmem.in);
+    for (size_t i = 0; i < avp64::psp::core::ARM_TIMER_COUNT; ++i)
+        test_cpu.timer_irq_out[i].stub();
+
+    tlm::tlm_global_quantum::instance().set(
+        sc_core::sc_time(1.0, sc_core::SC_MS));
+
+    // every loop iteration is a basic block of two instructions
+    vcml::u32 insn_loop[2] = { 0x91000442,   // 0x0: add x2, x2, #1
+                               0x17ffffff }; // 0x4: b 0x0
+
+    vcml::tlm_sbi info = vcml::SBI_NONE;
+    imem.write(r, &insn_loop, info);
+
+    vcml::u64 zero = 0;
+    EXPECT_TRUE(test_cpu.write_reg(32, &zero, 8));
+
+    sc_core::sc_time duration(20.0, sc_core::SC_MS);
+    double plain = run_mips(test_cpu, duration);
+
+    const std::string path = "bbtrace_bench.bin";
+    test_cpu.start_binary_trace(path);
+    double traced = run_mips(test_cpu, duration);
+    test_cpu.stop_binary_trace();
+
+    avp64::psp::bb_trace_reader reader(path);
+    vcml::u64 vaddr, time_ps;
+    ASSERT_TRUE(reader.next(vaddr, time_ps));
+    EXPECT_EQ(vaddr, 0x0);
+
+    std::printf("without trace : %.1f MIPS\n", plain);
+    std::printf("binary trace  : %.1f MIPS\n", traced);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,53 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/core_stats.h"
+
+#include <gtest/gtest.h>
+
+using avp64::psp::core_stats;
+
+TEST(avp64, core_stats) {
+    core_stats a;
+    EXPECT_EQ(a.to_csv(), "0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0");
+
+    a.quanta = 2;
+    a.transport_read = 10;
+    a.syscalls = 1;
+    a.tb_flushes = 1;
+
+    core_stats b;
+    b.quanta = 1;
+    b.transport_read = 4;
+
+    core_stats total;
+    total += a;
+    total += b;
+    EXPECT_EQ(total.quanta, 3);
+    EXPECT_EQ(total.transport_read, 14);
+    EXPECT_EQ(total.syscalls, 1);
+
+    core_stats delta = total - b;
+    EXPECT_EQ(delta.quanta, 2);
+    EXPECT_EQ(delta.transport_read, 10);
+
+    EXPECT_EQ(core_stats::csv_header().substr(0, 22),
+              "quanta,transport_read,");
+    EXPECT_EQ(delta.to_csv(), "2,10,0,0,0,0,0,0,0,0,0,0,1,1,0,0");
+
+    std::string json = delta.to_json();
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_EQ(json.back(), '}');
+    EXPECT_NE(json.find("\"quanta\":2,"), std::string::npos);
+    EXPECT_NE(json.find("\"syscalls\":1"), std::string::npos);
+    EXPECT_NE(json.find("\"code_pages_retranslated\":0"), std::string::npos);
+
+    delta.reset();
+    EXPECT_EQ(delta.to_csv(), "0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0");
+}
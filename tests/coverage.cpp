@@ -0,0 +1,61 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/coverage.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+
+using avp64::psp::coverage_map;
+
+TEST(avp64, coverage) {
+    coverage_map a;
+    EXPECT_TRUE(a.empty());
+
+    a.set(0x40000000);
+    a.set(0x40000004);
+    a.set(0x40000004);
+    a.set(0x40001ffc);
+    EXPECT_EQ(a.count(), 3);
+    EXPECT_EQ(a.num_pages(), 2);
+    EXPECT_TRUE(a.test(0x40000004));
+    EXPECT_FALSE(a.test(0x40000008));
+    EXPECT_FALSE(a.test(0x80000004));
+
+    // merging is a union of both maps
+    coverage_map b;
+    b.set(0x40000004);
+    b.set(0xffff000000001000);
+    a.merge(b);
+    EXPECT_EQ(a.count(), 4);
+    EXPECT_TRUE(a.test(0xffff000000001000));
+
+    std::vector<vcml::u64> addrs;
+    a.for_each([&](vcml::u64 addr) { addrs.push_back(addr); });
+    std::vector<vcml::u64> expect = { 0x40000000, 0x40000004, 0x40001ffc,
+                                      0xffff000000001000 };
+    EXPECT_EQ(addrs, expect);
+
+    // loading merges the file into the existing map
+    const std::string path = "coverage_test.cov";
+    a.save(path);
+
+    coverage_map c;
+    c.set(0x80000000);
+    c.load(path);
+    EXPECT_EQ(c.count(), 5);
+    EXPECT_TRUE(c.test(0x40001ffc));
+    EXPECT_TRUE(c.test(0x80000000));
+
+    c.clear();
+    EXPECT_TRUE(c.empty());
+    EXPECT_FALSE(c.test(0x80000000));
+
+    std::remove(path.c_str());
+}
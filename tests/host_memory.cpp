@@ -0,0 +1,63 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/host_memory.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sys/mman.h>
+
+TEST(avp64, host_memory) {
+    const size_t page_size = mwr::get_page_size();
+    const size_t size = 64 * page_size;
+
+    auto* ram = static_cast<vcml::u8*>(
+        mmap(nullptr, size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+    ASSERT_NE(ram, MAP_FAILED);
+
+    // anonymous memory only becomes resident when it is touched
+    EXPECT_EQ(avp64::psp::resident_size(ram, size), 0);
+    ram[0] = 1;
+    ram[10 * page_size + 5] = 1;
+    ram[11 * page_size] = 1;
+    EXPECT_EQ(avp64::psp::resident_size(ram, size), 3 * page_size);
+    EXPECT_EQ(avp64::psp::resident_size(ram + 10 * page_size + 5, 1),
+              page_size);
+
+    const std::string path = "host_memory_test.bin";
+    std::vector<vcml::u8> image(2 * page_size + 100);
+    for (size_t i = 0; i < image.size(); ++i)
+        image[i] = i * 13;
+
+    std::ofstream os(path, std::ios::binary);
+    os.write(reinterpret_cast<const char*>(image.data()), image.size());
+    os.close();
+
+    // images are mapped page aligned only and must fit
+    EXPECT_EQ(avp64::psp::map_file(ram + 1, size, path), 0);
+    EXPECT_EQ(avp64::psp::map_file(ram, page_size, path), 0);
+    EXPECT_EQ(avp64::psp::map_file(ram, size, "nonexistent.bin"), 0);
+
+    vcml::u8* dest = ram + 8 * page_size;
+    ASSERT_EQ(avp64::psp::map_file(dest, size, path), image.size());
+    EXPECT_EQ(std::memcmp(dest, image.data(), image.size()), 0);
+    EXPECT_EQ(dest[image.size()], 0);
+    EXPECT_EQ(ram[11 * page_size], 1);
+
+    // writes go to a private copy, the image is left untouched
+    dest[0] = ~image[0];
+    std::ifstream is(path, std::ios::binary);
+    EXPECT_EQ(is.get(), image[0]);
+
+    munmap(ram, size);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,94 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/host_page_table.h"
+
+#include <gtest/gtest.h>
+#include <set>
+
+using avp64::psp::host_page_table;
+using avp64::psp::target_page_data;
+using avp64::psp::target_page_list;
+
+constexpr vcml::u64 PAGE_BITS = 12;
+
+static void* page(vcml::u64 n) {
+    return reinterpret_cast<void*>(n << PAGE_BITS);
+}
+
+TEST(avp64, host_page_table) {
+    host_page_table table(PAGE_BITS);
+    std::set<vcml::u64> present;
+
+    // insert enough pages to trigger several rehashes, including pages
+    // that differ only in their upper address bits
+    for (vcml::u64 i = 1; i <= 1000; ++i) {
+        table.insert(page(i)).locked = true;
+        table.insert(page(i << 20)).locked = true;
+        present.insert(i);
+        present.insert(i << 20);
+    }
+
+    EXPECT_EQ(table.size(), present.size());
+    for (vcml::u64 n : present) {
+        ASSERT_NE(table.find(page(n)), nullptr);
+        EXPECT_TRUE(table.find(page(n))->locked);
+    }
+
+    // inserting again must return the existing entry
+    table.insert(page(1)).locked = false;
+    EXPECT_EQ(table.size(), present.size());
+    EXPECT_FALSE(table.find(page(1))->locked);
+
+    // erase every third page, all others must remain reachable
+    for (vcml::u64 i = 1; i <= 1000; i += 3) {
+        EXPECT_TRUE(table.erase(page(i)));
+        EXPECT_TRUE(table.erase(page(i << 20)));
+        present.erase(i);
+        present.erase(i << 20);
+    }
+
+    EXPECT_FALSE(table.erase(page(1)));
+    EXPECT_EQ(table.find(page(1)), nullptr);
+    EXPECT_EQ(table.size(), present.size());
+    for (vcml::u64 n : present)
+        EXPECT_NE(table.find(page(n)), nullptr);
+
+    std::set<vcml::u64> visited;
+    table.for_each([&](void* p, auto& data) {
+        visited.insert(reinterpret_cast<vcml::u64>(p) >> PAGE_BITS);
+    });
+    EXPECT_EQ(visited, present);
+
+    table.clear();
+    EXPECT_TRUE(table.empty());
+    EXPECT_EQ(table.find(page(2)), nullptr);
+}
+
+TEST(avp64, target_page_list) {
+    target_page_list list;
+    constexpr size_t n = 3 * target_page_list::INLINE_SLOTS;
+
+    for (vcml::u64 i = 0; i < n; ++i)
+        list.push_back(target_page_data{ nullptr, i, 4096, nullptr });
+    EXPECT_EQ(list.size(), n);
+
+    // remove all odd pages, spanning inline and spilled slots
+    list.remove_if([](const target_page_data& tp) { return tp.page_addr & 1; });
+    EXPECT_EQ(list.size(), n / 2);
+
+    std::set<vcml::u64> pages;
+    for (size_t i = 0; i < list.size(); ++i)
+        pages.insert(list[i].page_addr);
+    for (vcml::u64 i = 0; i < n; i += 2)
+        EXPECT_EQ(pages.count(i), 1);
+
+    list.remove_if([](const target_page_data& tp) { return true; });
+    EXPECT_TRUE(list.empty());
+}
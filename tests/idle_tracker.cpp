@@ -0,0 +1,35 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/idle_tracker.h"
+
+#include <gtest/gtest.h>
+
+using avp64::psp::idle_tracker;
+
+TEST(avp64, idle_tracker) {
+    idle_tracker idle(3);
+
+    // the cluster is only idle once all cores wait for interrupts
+    idle.enter(0, 100);
+    idle.enter(2, 200);
+    idle.enter(2, 250);
+    EXPECT_EQ(idle.idle_periods(), 0);
+    idle.enter(1, 300);
+    EXPECT_EQ(idle.idle_periods(), 1);
+
+    idle.leave(1, 1300);
+    idle.leave(1, 1400);
+    EXPECT_EQ(idle.idle_time_ps(), 1000);
+
+    idle.enter(1, 2000);
+    idle.leave(0, 2500);
+    EXPECT_EQ(idle.idle_periods(), 2);
+    EXPECT_EQ(idle.idle_time_ps(), 1500);
+}
@@ -13,6 +13,9 @@
 #include <gmock/gmock.h>
 #include <cstdlib>
 #include <cstring>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
 
 constexpr vcml::u64 TARGET_PAGE_SIZE = 4096;
 
@@ -23,11 +26,18 @@ public:
 
     virtual vcml::u64 page_size() override { return TARGET_PAGE_SIZE; }
     MOCK_METHOD(void, update_page, (vcml::u64 page_addr), (override));
+    MOCK_METHOD(void, page_written,
+                (avp64::psp::mem_protector_if* const* owners, size_t n),
+                (override));
 };
 
 TEST(avp64, mem_protector) {
     mock_core core;
     auto& mp = avp64::psp::mem_protector::instance();
+
+    // every write fault reports its only owner once
+    EXPECT_CALL(core, page_written(testing::_, 1))
+        .Times(testing::AnyNumber());
     constexpr size_t target_page_cnt = 8;
 
     auto* test_pages = reinterpret_cast<vcml::u8*>(std::aligned_alloc(
@@ -92,5 +102,255 @@ TEST(avp64, mem_protector) {
         EXPECT_EQ(test_pages[2 * TARGET_PAGE_SIZE], 7);
     }
 
+    // deregistering an unrelated range leaves the page protected
+    mp.register_page(&core, 0, &test_pages[0]);
+    mp.deregister_pages(&core, target_page_cnt * TARGET_PAGE_SIZE,
+                        ~0ull);
+
+    EXPECT_CALL(core, update_page(0)).Times(1);
+    test_pages[1] = 8;
+    EXPECT_EQ(test_pages[1], 8);
+
+    std::free(test_pages);
+}
+
+TEST(avp64, mem_protector_batch) {
+    if (mwr::get_page_size() != TARGET_PAGE_SIZE)
+        GTEST_SKIP() << "test requires host page size == target page size";
+
+    mock_core core;
+    auto& mp = avp64::psp::mem_protector::instance();
+
+    // every write fault reports its only owner once
+    EXPECT_CALL(core, page_written(testing::_, 1))
+        .Times(testing::AnyNumber());
+    constexpr size_t target_page_cnt = 8;
+
+    auto* test_pages = reinterpret_cast<vcml::u8*>(std::aligned_alloc(
+        mwr::get_page_size(), target_page_cnt * TARGET_PAGE_SIZE));
+    std::memset(test_pages, 0, target_page_cnt * TARGET_PAGE_SIZE);
+
+    // pages are protected as soon as they are registered
+    for (size_t i = 0; i < target_page_cnt; ++i)
+        mp.register_page(&core, i * TARGET_PAGE_SIZE,
+                         &test_pages[i * TARGET_PAGE_SIZE]);
+
+    EXPECT_CALL(core, update_page(0)).Times(1);
+    test_pages[1] = 2;
+    EXPECT_EQ(test_pages[1], 2);
+
+    // unprotecting a range uses a single mprotect call
+    vcml::u64 calls = mp.num_mprotect();
+    mp.deregister_pages(&core, 0, target_page_cnt * TARGET_PAGE_SIZE - 1);
+    EXPECT_EQ(mp.num_mprotect(), calls + 1);
+
+    test_pages[(target_page_cnt - 1) * TARGET_PAGE_SIZE] = 4;
+    EXPECT_EQ(test_pages[(target_page_cnt - 1) * TARGET_PAGE_SIZE], 4);
+
     std::free(test_pages);
 }
+
+class counting_core : public avp64::psp::mem_protector_if
+{
+public:
+    std::atomic<vcml::u64> updates{ 0 };
+
+    virtual ~counting_core() override = default;
+
+    virtual vcml::u64 page_size() override { return TARGET_PAGE_SIZE; }
+    virtual void update_page(vcml::u64 page_addr) override { updates++; }
+};
+
+TEST(avp64, mem_protector_threads) {
+    if (mwr::get_page_size() != TARGET_PAGE_SIZE)
+        GTEST_SKIP() << "test requires host page size == target page size";
+
+    constexpr size_t ncores = 8;
+    constexpr size_t npages = 32;
+    constexpr size_t iterations = 2000;
+
+    auto& mp = avp64::psp::mem_protector::instance();
+    std::array<counting_core, ncores> cores;
+
+    auto* test_pages = reinterpret_cast<vcml::u8*>(std::aligned_alloc(
+        mwr::get_page_size(), npages * TARGET_PAGE_SIZE));
+    std::memset(test_pages, 0, npages * TARGET_PAGE_SIZE);
+
+    // every core protects and writes to the same code pages
+    auto run = [&](size_t id) {
+        auto* core = &cores[id];
+        for (size_t i = 0; i < iterations; ++i) {
+            size_t page = (id * 7 + i) % npages;
+            mp.register_page(core, page * TARGET_PAGE_SIZE,
+                             &test_pages[page * TARGET_PAGE_SIZE]);
+
+            page = (id + 3 * i) % npages;
+            test_pages[page * TARGET_PAGE_SIZE + id] = i & 0xff;
+            EXPECT_EQ(test_pages[page * TARGET_PAGE_SIZE + id], i & 0xff);
+
+            if (i % 128 == 0)
+                mp.deregister_pages(core, 0, npages * TARGET_PAGE_SIZE - 1);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t id = 0; id < ncores; ++id)
+        threads.emplace_back(run, id);
+    for (auto& t : threads)
+        t.join();
+
+    vcml::u64 updates = 0;
+    for (auto& core : cores)
+        updates += core.updates;
+    EXPECT_GT(updates, 0);
+
+    for (auto& core : cores)
+        mp.deregister_pages(&core, 0, ~0ull);
+
+    // all pages must be writable again
+    for (size_t page = 0; page < npages; ++page)
+        test_pages[page * TARGET_PAGE_SIZE] = 0xff;
+
+    std::free(test_pages);
+}
+
+class large_page_core : public avp64::psp::mem_protector_if
+{
+public:
+    vcml::u64 size;
+
+    explicit large_page_core(vcml::u64 sz): size(sz) {}
+    virtual ~large_page_core() override = default;
+
+    virtual vcml::u64 page_size() override { return size; }
+    MOCK_METHOD(void, update_page, (vcml::u64 page_addr), (override));
+    MOCK_METHOD(void, update_page_range,
+                (vcml::u64 page_addr, vcml::u64 start, vcml::u64 end),
+                (override));
+};
+
+TEST(avp64, mem_protector_large_pages) {
+    const vcml::u64 host_page_size = mwr::get_page_size();
+    constexpr size_t host_pages_per_target = 4;
+    constexpr vcml::u64 page_addr = 0x40000000;
+
+    large_page_core core(host_pages_per_target * host_page_size);
+    auto& mp = avp64::psp::mem_protector::instance();
+
+    auto* test_page = reinterpret_cast<vcml::u8*>(
+        std::aligned_alloc(core.size, core.size));
+    std::memset(test_page, 0, core.size);
+
+    // a target page spanning multiple host pages protects all of them
+    mp.register_page(&core, page_addr, test_page);
+
+    // writes only invalidate the part of the target page that was written
+    vcml::u64 start = page_addr + 2 * host_page_size;
+    EXPECT_CALL(core, update_page_range(page_addr, start,
+                                        start + host_page_size - 1))
+        .Times(1);
+    test_page[2 * host_page_size + 8] = 1;
+    EXPECT_EQ(test_page[2 * host_page_size + 8], 1);
+
+    // the other host pages of the target page stay protected
+    EXPECT_CALL(core, update_page_range(page_addr, page_addr,
+                                        page_addr + host_page_size - 1))
+        .Times(1);
+    test_page[0] = 2;
+    EXPECT_EQ(test_page[0], 2);
+
+    // registering again only re-protects the written host pages
+    vcml::u64 calls = mp.num_mprotect();
+    mp.register_page(&core, page_addr, test_page);
+    EXPECT_EQ(mp.num_mprotect(), calls + 2);
+
+    // deregistering releases all host pages of the target page
+    mp.deregister_page(&core, page_addr);
+    for (size_t i = 0; i < host_pages_per_target; ++i)
+        test_page[i * host_page_size] = 3;
+
+    std::free(test_page);
+}
+
+TEST(avp64, mem_protector_owners) {
+    if (mwr::get_page_size() != TARGET_PAGE_SIZE)
+        GTEST_SKIP() << "test requires host page size == target page size";
+
+    mock_core a, b, c;
+    auto& mp = avp64::psp::mem_protector::instance();
+
+    auto* test_pages = reinterpret_cast<vcml::u8*>(
+        std::aligned_alloc(mwr::get_page_size(), 2 * TARGET_PAGE_SIZE));
+    std::memset(test_pages, 0, 2 * TARGET_PAGE_SIZE);
+
+    // only cores that registered a page are notified about writes to it
+    mp.register_page(&a, 0, &test_pages[0]);
+    mp.register_page(&b, 0, &test_pages[0]);
+    mp.register_page(&c, TARGET_PAGE_SIZE, &test_pages[TARGET_PAGE_SIZE]);
+
+    EXPECT_CALL(a, update_page(0)).Times(1);
+    EXPECT_CALL(b, update_page(0)).Times(1);
+    EXPECT_CALL(c, update_page(testing::_)).Times(0);
+    EXPECT_CALL(a, page_written(testing::_, 2)).Times(1);
+    EXPECT_CALL(b, page_written(testing::_, testing::_)).Times(0);
+    test_pages[0] = 1;
+    EXPECT_EQ(test_pages[0], 1);
+
+    testing::Mock::VerifyAndClearExpectations(&c);
+    EXPECT_CALL(c, update_page(TARGET_PAGE_SIZE)).Times(1);
+    EXPECT_CALL(c, page_written(testing::_, 1)).Times(1);
+    test_pages[TARGET_PAGE_SIZE] = 2;
+    EXPECT_EQ(test_pages[TARGET_PAGE_SIZE], 2);
+
+    for (auto* core : { &a, &b, &c })
+        mp.deregister_pages(core, 0, ~0ull);
+
+    std::free(test_pages);
+}
+
+static void check_fork(avp64::psp::mem_protector& mp) {
+    counting_core core;
+    auto* test_pages = reinterpret_cast<vcml::u8*>(
+        std::aligned_alloc(mwr::get_page_size(), 2 * TARGET_PAGE_SIZE));
+    std::memset(test_pages, 0, 2 * TARGET_PAGE_SIZE);
+
+    mp.register_page(&core, 0, &test_pages[0]);
+    mp.register_page(&core, TARGET_PAGE_SIZE, &test_pages[TARGET_PAGE_SIZE]);
+
+    // the child must still catch writes to protected pages of its own copy
+    mp.before_fork();
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    mp.after_fork(pid == 0);
+    if (pid == 0) {
+        test_pages[TARGET_PAGE_SIZE] = 1;
+        _exit(core.updates == 1 && test_pages[0] == 0 ? 0 : 1);
+    }
+
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+
+    // writes of the child are not visible to the parent
+    EXPECT_EQ(test_pages[TARGET_PAGE_SIZE], 0);
+    EXPECT_EQ(core.updates, 0);
+    test_pages[0] = 2;
+    EXPECT_EQ(core.updates, 1);
+
+    mp.deregister_pages(&core, 0, ~0ull);
+    std::free(test_pages);
+}
+
+TEST(avp64, mem_protector_fork) {
+    if (mwr::get_page_size() != TARGET_PAGE_SIZE)
+        GTEST_SKIP() << "test requires host page size == target page size";
+
+    auto& mp = avp64::psp::mem_protector::instance();
+    check_fork(mp);
+
+    if (mp.set_backend(avp64::psp::mem_protector::BACKEND_USERFAULTFD)) {
+        check_fork(mp);
+        mp.set_backend(avp64::psp::mem_protector::BACKEND_SIGNAL);
+    }
+}
@@ -0,0 +1,181 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/mem_protector.h"
+
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <atomic>
+#include <cstdio>
+
+constexpr vcml::u64 TARGET_PAGE_SIZE = 4096;
+
+class bench_core : public avp64::psp::mem_protector_if
+{
+public:
+    std::atomic<vcml::u64> updates{ 0 };
+
+    virtual ~bench_core() override = default;
+
+    virtual vcml::u64 page_size() override { return TARGET_PAGE_SIZE; }
+    virtual void update_page(vcml::u64 page_addr) override { updates++; }
+};
+
+class bench_memory
+{
+private:
+    vcml::u8* m_data;
+    size_t m_size;
+
+public:
+    bench_memory(size_t size): m_data(nullptr), m_size(size) {
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p != MAP_FAILED)
+            m_data = reinterpret_cast<vcml::u8*>(p);
+    }
+
+    ~bench_memory() {
+        if (m_data)
+            ::munmap(m_data, m_size);
+    }
+
+    vcml::u8* data() const { return m_data; }
+};
+
+static void report(const char* name, size_t n, double seconds) {
+    std::printf("%-32s: %zu ops in %.3f ms (%.1f Mops/s)\n", name, n,
+                seconds * 1e3, seconds > 0.0 ? n / seconds / 1e6 : 0.0);
+}
+
+TEST(avp64, mem_protector_deregister) {
+    constexpr size_t npages = 100000;
+    constexpr size_t chunk = 64; // pages invalidated per dmi invalidation
+
+    bench_core core;
+    auto& mp = avp64::psp::mem_protector::instance();
+    bench_memory mem(npages * TARGET_PAGE_SIZE);
+    ASSERT_NE(mem.data(), nullptr);
+
+    auto register_all = [&]() -> double {
+        double t = mwr::timestamp();
+        for (size_t i = 0; i < npages; ++i) {
+            mp.register_page(&core, i * TARGET_PAGE_SIZE,
+                             mem.data() + i * TARGET_PAGE_SIZE);
+        }
+        return mwr::timestamp() - t;
+    };
+
+    report("register_page", npages, register_all());
+
+    // deregister in dmi-invalidation sized ranges
+    double t = mwr::timestamp();
+    for (size_t i = 0; i < npages; i += chunk) {
+        mp.deregister_pages(&core, i * TARGET_PAGE_SIZE,
+                            (i + chunk) * TARGET_PAGE_SIZE - 1);
+    }
+    report("deregister_pages", npages, mwr::timestamp() - t);
+
+    // all pages must be writable again without notifying the core
+    mem.data()[0] = 1;
+    mem.data()[(npages - 1) * TARGET_PAGE_SIZE] = 1;
+    EXPECT_EQ(core.updates, 0);
+
+    register_all();
+
+    // deregister page by page
+    t = mwr::timestamp();
+    for (size_t i = 0; i < npages; ++i)
+        mp.deregister_page(&core, i * TARGET_PAGE_SIZE);
+    report("deregister_page", npages, mwr::timestamp() - t);
+
+    mem.data()[TARGET_PAGE_SIZE] = 2;
+    EXPECT_EQ(core.updates, 0);
+
+    // invalidating unrelated ranges must not touch protected pages
+    register_all();
+    t = mwr::timestamp();
+    for (size_t i = 0; i < npages; ++i) {
+        vcml::u64 addr = (npages + i) * TARGET_PAGE_SIZE;
+        mp.deregister_pages(&core, addr, addr + TARGET_PAGE_SIZE - 1);
+    }
+    report("deregister_pages (miss)", npages, mwr::timestamp() - t);
+
+    mem.data()[2 * TARGET_PAGE_SIZE] = 3;
+    EXPECT_EQ(core.updates, 1);
+
+    mp.deregister_pages(&core, 0, ~0ull);
+}
+
+TEST(avp64, mem_protector_faults) {
+    constexpr size_t npages = 4096;
+    constexpr size_t rounds = 16;
+
+    bench_core core;
+    auto& mp = avp64::psp::mem_protector::instance();
+    bench_memory mem(npages * TARGET_PAGE_SIZE);
+    ASSERT_NE(mem.data(), nullptr);
+
+    double total = 0.0;
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < npages; ++i) {
+            mp.register_page(&core, i * TARGET_PAGE_SIZE,
+                             mem.data() + i * TARGET_PAGE_SIZE);
+        }
+
+        // every first write to a page faults into the signal handler
+        double t = mwr::timestamp();
+        for (size_t i = 0; i < npages; ++i)
+            mem.data()[i * TARGET_PAGE_SIZE] = r;
+        total += mwr::timestamp() - t;
+    }
+
+    report("write faults", npages * rounds, total);
+    EXPECT_EQ(core.updates, npages * rounds);
+
+    mp.deregister_pages(&core, 0, ~0ull);
+}
+
+static void bench_backend(avp64::psp::mem_protector::backend_kind backend,
+                          const char* name) {
+    constexpr size_t npages = 4096;
+
+    bench_core core;
+    auto& mp = avp64::psp::mem_protector::instance();
+    bench_memory mem(npages * TARGET_PAGE_SIZE);
+    ASSERT_NE(mem.data(), nullptr);
+
+    if (!mp.set_backend(backend)) {
+        std::printf("%-32s: not supported by host\n", name);
+        return;
+    }
+
+    for (size_t i = 0; i < npages; ++i) {
+        mem.data()[i * TARGET_PAGE_SIZE] = 0; // populate page
+        mp.register_page(&core, i * TARGET_PAGE_SIZE,
+                         mem.data() + i * TARGET_PAGE_SIZE);
+    }
+
+    double t = mwr::timestamp();
+    for (size_t i = 0; i < npages; ++i)
+        mem.data()[i * TARGET_PAGE_SIZE] = 1;
+    t = mwr::timestamp() - t;
+
+    std::printf("%-32s: %.2f us per write fault\n", name, t / npages * 1e6);
+    EXPECT_EQ(core.updates, npages);
+
+    mp.deregister_pages(&core, 0, ~0ull);
+    EXPECT_TRUE(mp.set_backend(avp64::psp::mem_protector::BACKEND_SIGNAL));
+}
+
+TEST(avp64, mem_protector_backends) {
+    bench_backend(avp64::psp::mem_protector::BACKEND_SIGNAL, "signal");
+    bench_backend(avp64::psp::mem_protector::BACKEND_USERFAULTFD,
+                  "userfaultfd");
+}
@@ -0,0 +1,78 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include "avp64/psp/core.h"
+
+class mmio_bench_core : public avp64::psp::core
+{
+public:
+    mmio_bench_core(): avp64::psp::core("bench_core", 0, 1) {}
+    bool read_reg(id_t regno, void* buf, size_t len) {
+        return read_reg_dbg(regno, buf, len);
+    }
+    bool write_reg(id_t regno, const void* buf, size_t len) {
+        return write_reg_dbg(regno, buf, len);
+    }
+};
+
+TEST(avp64, mmio_bench) {
+    mmio_bench_core test_cpu;
+
+    mwr::hz_t defclk = 100 * mwr::MHz;
+    vcml::generic::clock clock("clk", defclk);
+    vcml::generic::reset reset("rst");
+
+    vcml::generic::memory imem("imem", 0x1000);
+    vcml::generic::bus bus("bus");
+    vcml::generic::hwrng hwrng("hwrng");
+    vcml::range r(0x0, 0xf);
+
+    clock.clk.bind(test_cpu.clk);
+    clock.clk.bind(imem.clk);
+    clock.clk.bind(bus.clk);
+    clock.clk.bind(hwrng.clk);
+    reset.rst.bind(test_cpu.rst);
+    reset.rst.bind(imem.rst);
+    reset.rst.bind(bus.rst);
+    reset.rst.bind(hwrng.rst);
+    test_cpu.insn.bind(imem.in);
+    bus.bind(test_cpu.data);
+    bus.bind(hwrng.in, vcml::range(0x0, 0xfff));
+    for (size_t i = 0; i < avp64::psp::core::ARM_TIMER_COUNT; ++i)
+        test_cpu.timer_irq_out[i].stub();
+
+    sc_core::sc_time duration(10.0, sc_core::SC_MS);
+    tlm::tlm_global_quantum::instance().set(
+        sc_core::sc_time(1.0, sc_core::SC_MS));
+
+    // polling loop reading a device register
+    vcml::u32 insn_poll[4] = { 0xd2800000,   // 0x0: mov x0, #0
+                               0xb9400001,   // 0x4: ldr w1, [x0]
+                               0x91000442,   // 0x8: add x2, x2, #1
+                               0x17fffffe }; // 0xc: b 0x4
+
+    vcml::tlm_sbi info = vcml::SBI_NONE;
+    imem.write(r, &insn_poll, info);
+
+    vcml::u64 zero = 0;
+    EXPECT_TRUE(test_cpu.write_reg(32, &zero, 8));
+    EXPECT_TRUE(test_cpu.write_reg(2, &zero, 8));
+
+    double t = mwr::timestamp();
+    sc_core::sc_start(duration);
+    t = mwr::timestamp() - t;
+
+    vcml::u64 accesses = 0;
+    EXPECT_TRUE(test_cpu.read_reg(2, &accesses, 8));
+    EXPECT_GT(accesses, 0);
+
+    std::printf("mmio polling: %zu accesses in %.3f s (%.2f M/s)\n",
+                static_cast<size_t>(accesses), t, accesses / t / 1e6);
+}
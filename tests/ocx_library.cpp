@@ -0,0 +1,31 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include "avp64/psp/core.h"
+
+using avp64::psp::ocx_library;
+
+TEST(avp64, ocx_library) {
+    EXPECT_EQ(ocx_library::users(), 0);
+
+    {
+        avp64::psp::core a("core0", 0, 0);
+        avp64::psp::core b("core1", 0, 1);
+        EXPECT_EQ(ocx_library::users(), 2);
+
+        auto lib = ocx_library::get();
+        EXPECT_EQ(ocx_library::users(), 3);
+        EXPECT_EQ(lib, ocx_library::get());
+    }
+
+    // unloaded with the last core and loaded again on demand
+    EXPECT_EQ(ocx_library::users(), 0);
+    EXPECT_NE(ocx_library::get(), nullptr);
+}
@@ -0,0 +1,68 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/profiler.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+
+using avp64::psp::profiler;
+
+static std::string symbolize(vcml::u64 addr) {
+    // functions are 0x100 bytes large in this test
+    switch (addr & ~0xffull) {
+    case 0x1000:
+        return "main";
+    case 0x2000:
+        return "work";
+    case 0x3000:
+        return "memcpy";
+    default:
+        return mwr::mkstr("0x%llx", static_cast<unsigned long long>(addr));
+    }
+}
+
+TEST(avp64, profiler) {
+    // small capacity to fold several times
+    profiler prof(80);
+
+    const vcml::u64 in_work[] = { 0x2010, 0x1020 };
+    const vcml::u64 in_memcpy[] = { 0x3004, 0x2040, 0x1020 };
+    const vcml::u64 in_main[] = { 0x1008 };
+
+    for (int i = 0; i < 20; ++i) {
+        prof.sample(100, in_work, 2);
+        prof.sample(50, in_memcpy, 3);
+        prof.sample(10, in_main, 1);
+    }
+
+    prof.sample(10, in_main, 0); // empty samples are ignored
+    EXPECT_EQ(prof.num_samples(), 60);
+    EXPECT_EQ(prof.total_weight(), 20 * 160);
+
+    std::stringstream flat;
+    prof.write_flat(flat, symbolize);
+    EXPECT_EQ(flat.str(), "# samples: 60, weight: 3200\n"
+                          " 62.50%         2000  work\n"
+                          " 31.25%         1000  memcpy\n"
+                          "  6.25%          200  main\n");
+
+    std::stringstream folded;
+    prof.write_folded(folded, symbolize);
+    EXPECT_EQ(folded.str(), "main 200\n"
+                            "main;work 2000\n"
+                            "main;work;memcpy 1000\n");
+
+    prof.reset();
+    EXPECT_EQ(prof.num_samples(), 0);
+
+    std::stringstream empty;
+    prof.write_folded(empty, symbolize);
+    EXPECT_TRUE(empty.str().empty());
+}
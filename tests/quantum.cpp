@@ -0,0 +1,54 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/quantum.h"
+
+#include <gtest/gtest.h>
+
+using avp64::psp::quantum_controller;
+
+TEST(avp64, quantum_controller) {
+    quantum_controller ctrl;
+    EXPECT_FALSE(ctrl.enabled());
+
+    ctrl.configure(1000, 16000);
+    EXPECT_TRUE(ctrl.enabled());
+    EXPECT_EQ(ctrl.quantum(), 1000);
+
+    // quiet quanta grow the quantum up to its maximum
+    for (size_t i = 0; i < 100; ++i)
+        ctrl.update(ctrl.quantum());
+    EXPECT_EQ(ctrl.quantum(), 16000);
+
+    // single events keep the current quantum
+    for (size_t i = 0; i < 10; ++i) {
+        ctrl.activity();
+        ctrl.update(ctrl.quantum());
+    }
+    EXPECT_EQ(ctrl.quantum(), 16000);
+
+    // clustered events shrink it down to its minimum
+    for (size_t i = 0; i < 10; ++i) {
+        ctrl.activity();
+        ctrl.activity();
+        ctrl.update(ctrl.quantum());
+    }
+    EXPECT_EQ(ctrl.quantum(), 1000);
+
+    const auto& hist = ctrl.quanta();
+    EXPECT_EQ(hist[quantum_controller::bucket(16000)], 95);
+    EXPECT_EQ(hist[quantum_controller::bucket(1000)], 10);
+    EXPECT_EQ(quantum_controller::bucket(1), 0);
+    EXPECT_EQ(quantum_controller::bucket(1024), 10);
+    EXPECT_EQ(quantum_controller::bucket(2047), 10);
+
+    ctrl.reset();
+    EXPECT_EQ(ctrl.quantum(), 1000);
+    EXPECT_EQ(ctrl.quanta()[quantum_controller::bucket(1000)], 0);
+}
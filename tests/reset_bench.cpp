@@ -0,0 +1,89 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include "avp64/psp/core.h"
+
+#include <cstdio>
+
+class reset_bench_core : public avp64::psp::core
+{
+public:
+    reset_bench_core(): avp64::psp::core("bench_core", 0, 1) {}
+    bool read_reg(id_t regno, void* buf, size_t len) {
+        return read_reg_dbg(regno, buf, len);
+    }
+};
+
+static double reset_latency(vcml::generic::reset& rst, size_t count) {
+    double start = mwr::timestamp();
+    for (size_t i = 0; i < count; ++i)
+        rst.rst.pulse();
+    return (mwr::timestamp() - start) / count;
+}
+
+TEST(avp64, reset_bench) {
+    reset_bench_core test_cpu;
+
+    mwr::hz_t defclk = 1 * mwr::kHz;
+    vcml::generic::clock clock("clk", defclk);
+    vcml::generic::reset reset("rst");
+
+    vcml::generic::memory imem("imem", 0x1000);
+    vcml::generic::memory dmem("dmem", 0x10000);
+    vcml::range r(0x0, 0xf);
+
+    clock.clk.bind(test_cpu.clk);
+    clock.clk.bind(imem.clk);
+    clock.clk.bind(dmem.clk);
+    reset.rst.bind(test_cpu.rst);
+    reset.rst.bind(imem.rst);
+    reset.rst.bind(dmem.rst);
+    test_cpu.insn.bind(imem.in);
+    test_cpu.data.bind(dmem.in);
+    for (size_t i = 0; i < avp64::psp::core::ARM_TIMER_COUNT; ++i)
+        test_cpu.timer_irq_out[i].stub();
+
+    sc_core::sc_time quantum(1.0, sc_core::SC_SEC);
+    tlm::tlm_global_quantum::instance().set(quantum);
+
+    vcml::u32 insn[4] = { 0xd2995fc0, // 0x0: mov x0, #0xcafe
+                          0xf9400001, // 0x4: ldr x1, [x0]
+                          0x14000000, // 0x8: b 0x8
+                          0x00000000 };
+
+    vcml::tlm_sbi info = vcml::SBI_NONE;
+    imem.write(r, &insn, info);
+
+    const size_t count = 200;
+    double latency[2] = {};
+    for (bool in_place : { false, true }) {
+        // the second round executes the code again from the reset state
+        test_cpu.reset_in_place = in_place;
+        sc_core::sc_start(quantum);
+
+        vcml::u64 pc = 0, x0 = 0;
+        EXPECT_TRUE(test_cpu.read_reg(32, &pc, 8));
+        EXPECT_TRUE(test_cpu.read_reg(0, &x0, 8));
+        EXPECT_EQ(pc, 0x8);
+        EXPECT_EQ(x0, 0xcafe);
+
+        latency[in_place] = reset_latency(reset, count);
+
+        EXPECT_TRUE(test_cpu.read_reg(32, &pc, 8));
+        EXPECT_TRUE(test_cpu.read_reg(0, &x0, 8));
+        EXPECT_EQ(pc, 0x0);
+        EXPECT_EQ(x0, 0x0);
+        EXPECT_EQ(test_cpu.cycle_count(), 0);
+    }
+
+    std::printf("reset latency: %.1f us recreate, %.1f us in place "
+                "(%.1fx)\n",
+                latency[0] * 1e6, latency[1] * 1e6, latency[0] / latency[1]);
+}
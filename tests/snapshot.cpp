@@ -0,0 +1,86 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/snapshot.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+
+using avp64::psp::snapshot;
+using avp64::psp::snapshot_section;
+
+TEST(avp64, snapshot_rle) {
+    vcml::u8 src[300];
+    for (size_t i = 0; i < sizeof(src); ++i)
+        src[i] = i < 200 ? 0xaa : i & 0xff;
+
+    vcml::u8 enc[sizeof(src)];
+    size_t n = avp64::psp::snapshot_rle_encode(src, sizeof(src), enc,
+                                               sizeof(enc));
+    ASSERT_GT(n, 0);
+    EXPECT_LT(n, 120);
+
+    vcml::u8 dec[sizeof(src)] = {};
+    EXPECT_TRUE(avp64::psp::snapshot_rle_decode(enc, n, dec, sizeof(dec)));
+    EXPECT_EQ(std::memcmp(src, dec, sizeof(src)), 0);
+
+    // incompressible data exceeds the limit
+    for (size_t i = 0; i < sizeof(src); ++i)
+        src[i] = i * 7;
+    EXPECT_EQ(avp64::psp::snapshot_rle_encode(src, sizeof(src), enc,
+                                              sizeof(enc)),
+              0);
+
+    // decoding to the wrong size fails
+    EXPECT_FALSE(avp64::psp::snapshot_rle_decode(enc, n, dec, 10));
+}
+
+TEST(avp64, snapshot) {
+    constexpr size_t size = 64 * snapshot_section::PAGE_SIZE + 100;
+    std::vector<vcml::u8> mem(size, 0);
+    for (size_t i = 0; i < 100; ++i)
+        mem[3 * snapshot_section::PAGE_SIZE + i] = i;
+    for (size_t i = 0; i < snapshot_section::PAGE_SIZE; ++i)
+        mem[10 * snapshot_section::PAGE_SIZE + i] = (i * 2654435761u) >> 7;
+    mem[size - 1] = 0x42;
+
+    snapshot snap;
+    snapshot_section& regs = snap.create("core0.regs");
+    regs.put<vcml::u64>(0x40080000);
+    regs.put<vcml::u32>(0x3c5);
+    regs.put_str("system.uart0.cr");
+
+    snapshot_section& ram = snap.create("ram");
+    ram.write_pages(mem.data(), mem.size());
+    EXPECT_EQ(ram.zero_pages(), 62);
+    EXPECT_LT(ram.size(), 2 * snapshot_section::PAGE_SIZE);
+
+    const std::string path = "snapshot_test.snp";
+    snap.save(path);
+
+    snapshot copy;
+    copy.load(path);
+    EXPECT_EQ(copy.num_sections(), 2);
+    EXPECT_TRUE(copy.has_section("ram"));
+    EXPECT_FALSE(copy.has_section("gic"));
+
+    snapshot_section& r = copy.section("core0.regs");
+    EXPECT_EQ(r.get<vcml::u64>(), 0x40080000);
+    EXPECT_EQ(r.get<vcml::u32>(), 0x3c5);
+    EXPECT_EQ(r.get_str(), "system.uart0.cr");
+    EXPECT_TRUE(r.eof());
+
+    // restored pages overwrite whatever was there before
+    std::vector<vcml::u8> restored(size, 0xff);
+    copy.section("ram").read_pages(restored.data(), restored.size());
+    EXPECT_EQ(restored, mem);
+
+    std::remove(path.c_str());
+}
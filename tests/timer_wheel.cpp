@@ -0,0 +1,53 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/timer_wheel.h"
+
+#include <gtest/gtest.h>
+
+using avp64::psp::timer_wheel;
+
+TEST(avp64, timer_wheel) {
+    timer_wheel wheel(4);
+    EXPECT_EQ(wheel.add_timers(4), 4);
+    EXPECT_EQ(wheel.size(), 8);
+    EXPECT_EQ(wheel.next(), timer_wheel::NONE);
+
+    // only changes of the earliest deadline are reported
+    EXPECT_TRUE(wheel.schedule(1, 1000));
+    EXPECT_FALSE(wheel.schedule(5, 3000));
+    EXPECT_TRUE(wheel.schedule(6, 500));
+    EXPECT_FALSE(wheel.schedule(5, 2000));
+    EXPECT_EQ(wheel.next(), 500);
+
+    // moving the earliest timer later falls back to the next one
+    EXPECT_TRUE(wheel.schedule(6, 4000));
+    EXPECT_EQ(wheel.next(), 1000);
+    EXPECT_FALSE(wheel.cancel(5));
+    EXPECT_TRUE(wheel.cancel(1));
+    EXPECT_EQ(wheel.next(), 4000);
+
+    // due timers are expired in index order and may be rescheduled
+    wheel.schedule(2, 4000);
+    wheel.schedule(3, 4500);
+    std::vector<size_t> fired;
+    size_t n = wheel.expire(4000, [&](size_t timer) {
+        fired.push_back(timer);
+        if (timer == 6)
+            wheel.schedule(6, 5000);
+    });
+
+    EXPECT_EQ(n, 2);
+    EXPECT_EQ(fired, std::vector<size_t>({ 2, 6 }));
+    EXPECT_EQ(wheel.deadline(2), timer_wheel::NONE);
+    EXPECT_EQ(wheel.deadline(6), 5000);
+    EXPECT_EQ(wheel.next(), 4500);
+
+    EXPECT_EQ(wheel.expire(4499, [](size_t) { FAIL(); }), 0);
+}
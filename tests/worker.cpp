@@ -0,0 +1,74 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright 2026 Nils Bosbach                                                *
+ *                                                                            *
+ * This software is licensed under the MIT license found in the               *
+ * LICENSE file at the root directory of this source tree.                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "avp64/psp/worker.h"
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+using avp64::psp::worker;
+
+TEST(avp64, worker) {
+    worker w(0);
+    const std::thread::id caller = std::this_thread::get_id();
+
+    // calls made by the job are executed by the thread in finish()
+    std::vector<int> order;
+    std::thread::id job_thread;
+    w.start([&]() {
+        job_thread = std::this_thread::get_id();
+        EXPECT_TRUE(w.on_worker());
+        for (int i = 0; i < 100; ++i) {
+            order.push_back(i);
+            w.call([&, i]() {
+                EXPECT_EQ(std::this_thread::get_id(), caller);
+                order.push_back(-i);
+            });
+        }
+    });
+
+    w.finish();
+    EXPECT_NE(job_thread, caller);
+    EXPECT_FALSE(w.on_worker());
+    ASSERT_EQ(order.size(), 200);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(order[2 * i], i);
+        EXPECT_EQ(order[2 * i + 1], -i);
+    }
+
+    EXPECT_EQ(w.num_jobs(), 1);
+    EXPECT_EQ(w.num_calls(), 100);
+
+    // calls outside of the worker thread are executed directly
+    bool direct = false;
+    w.call([&]() { direct = true; });
+    EXPECT_TRUE(direct);
+
+    // exceptions of calls are thrown on the worker, those of the job are
+    // thrown by finish
+    bool caught = false;
+    w.start([&]() {
+        try {
+            w.call([]() { throw std::runtime_error("call"); });
+        } catch (std::runtime_error&) {
+            caught = true;
+        }
+
+        throw std::runtime_error("job");
+    });
+
+    EXPECT_THROW(w.finish(), std::runtime_error);
+    EXPECT_TRUE(caught);
+
+    // the worker remains usable afterwards
+    int n = 0;
+    w.start([&]() { n = 42; });
+    w.finish();
+    EXPECT_EQ(n, 42);
+}